@@ -18,9 +18,21 @@ RC_ICONS = certinfo.ico
 HEADERS += \
     src/ca/caconcurrentgatherer.h \
     src/ca/certificate.h \
+    src/ca/certificatefetcher.h \
+    src/ca/concurrencycontroller.h \
+    src/ca/hostresolver.h \
+    src/ca/certificateinterntable.h \
     src/domainsources/browserhistorydb.h \
+    src/domainsources/historyindex.h \
     src/listmodel/caissuerlistmodel.h \
     src/ca/caprocessor.h \
+    src/ca/scancache.h \
+    src/ca/scancheckpoint.h \
+    src/ca/scanmetrics.h \
+    src/ca/scanresultwriter.h \
+    src/ca/scanscheduler.h \
+    src/ca/truststore.h \
+    src/cli/headlessscan.h \
     src/listmodel/domaincountlistmodel.h \
     src/domainsources/domainslisttextfile.h \
     src/listmodel/genericlistmodel.h \
@@ -30,8 +42,20 @@ HEADERS += \
 SOURCES += \
         src/ca/caconcurrentgatherer.cpp \
         src/domainsources/browserhistorydb.cpp \
+        src/domainsources/historyindex.cpp \
         src/listmodel/caissuerlistmodel.cpp \
         src/ca/caprocessor.cpp \
+        src/ca/certificatefetcher.cpp \
+        src/ca/concurrencycontroller.cpp \
+        src/ca/hostresolver.cpp \
+        src/ca/certificateinterntable.cpp \
+        src/ca/scancache.cpp \
+        src/ca/scancheckpoint.cpp \
+        src/ca/scanmetrics.cpp \
+        src/ca/scanresultwriter.cpp \
+        src/ca/scanscheduler.cpp \
+        src/ca/truststore.cpp \
+        src/cli/headlessscan.cpp \
         src/listmodel/domaincountlistmodel.cpp \
         src/domainsources/domainslisttextfile.cpp \
         src/main.cpp \
@@ -0,0 +1,52 @@
+# Benchmark for the certificate gathering pipeline, built on its own:
+#   qmake benchmark/benchmark.pro && make && ./benchmark --help
+# Needs the openssl command line tool to generate the certificate chains.
+
+QT += network sql widgets concurrent
+
+TARGET = benchmark
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS = -Wno-deprecated-declarations
+
+# sources include each other as "src/..."
+INCLUDEPATH += $$PWD/..
+
+HEADERS += \
+    tlsserverfarm.h \
+    ../src/ca/caconcurrentgatherer.h \
+    ../src/ca/caprocessor.h \
+    ../src/ca/certificate.h \
+    ../src/ca/certificatefetcher.h \
+    ../src/ca/concurrencycontroller.h \
+    ../src/ca/hostresolver.h \
+    ../src/ca/certificateinterntable.h \
+    ../src/ca/scancache.h \
+    ../src/ca/scancheckpoint.h \
+    ../src/ca/scanmetrics.h \
+    ../src/ca/scanresultwriter.h \
+    ../src/ca/scanscheduler.h \
+    ../src/ca/truststore.h \
+    ../src/listmodel/caissuerlistmodel.h \
+    ../src/listmodel/genericlistmodel.h \
+    ../src/listmodel/qabstractlistmodelwithrowcountsignal.h
+
+SOURCES += \
+    main.cpp \
+    tlsserverfarm.cpp \
+    ../src/ca/caconcurrentgatherer.cpp \
+    ../src/ca/caprocessor.cpp \
+    ../src/ca/certificatefetcher.cpp \
+    ../src/ca/concurrencycontroller.cpp \
+    ../src/ca/hostresolver.cpp \
+    ../src/ca/certificateinterntable.cpp \
+    ../src/ca/scancache.cpp \
+    ../src/ca/scancheckpoint.cpp \
+    ../src/ca/scanmetrics.cpp \
+    ../src/ca/scanresultwriter.cpp \
+    ../src/ca/scanscheduler.cpp \
+    ../src/ca/truststore.cpp \
+    ../src/listmodel/caissuerlistmodel.cpp
+
+win32: LIBS += -lpsapi
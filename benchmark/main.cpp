@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tlsserverfarm.h"
+#include "src/ca/caconcurrentgatherer.h"
+#include "src/ca/caprocessor.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+qint64 peakRssKiB()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize / 1024);
+    return -1;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("Sparkling Network");
+    app.setOrganizationDomain("raymii.org");
+    app.setApplicationName("CertInfo Benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs CAConcurrentGatherer against local TLS endpoints and reports throughput, latency and memory.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"hosts", "Number of hosts to scan, spread over the endpoints. Beyond --endpoints the names repeat, a repeated name is fetched once.", "n", "500"},
+        {"endpoints", "Number of local TLS endpoints.", "n", "500"},
+        {"chains", "Number of distinct certificate chains served.", "n", "8"},
+        {"concurrency", "Number of hosts checked at once (to start with).", "n", "10"},
+        {"per-group", "Maximum number of hosts of one endpoint checked at once.", "n", "4"},
+        {"fixed-concurrency", "Do not adapt the concurrency during the scan."},
+        {"handshake-only", "Only do the TLS handshake, no HTTP request."},
+        {"delay", "Delay before every handshake, in ms.", "ms", "0"},
+        {"jitter", "Random extra handshake delay, up to this many ms.", "ms", "0"},
+        {"hang-rate", "Fraction of endpoints that never answer (client timeout).", "fraction", "0"},
+        {"fail-rate", "Fraction of endpoints that fail the handshake.", "fraction", "0"},
+        {"sequential", "Afterwards, time this many blocking CAProcessor::getCertificate calls.", "n", "20"},
+        {"seed", "Seed for the endpoint behavior and delays.", "n", "1"},
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    TlsServerFarm::Options farmOptions;
+    farmOptions.endpoints = std::max(1, parser.value("endpoints").toInt());
+    farmOptions.chains = std::max(1, parser.value("chains").toInt());
+    farmOptions.delayMs = parser.value("delay").toInt();
+    farmOptions.jitterMs = parser.value("jitter").toInt();
+    farmOptions.hangRate = parser.value("hang-rate").toDouble();
+    farmOptions.failRate = parser.value("fail-rate").toDouble();
+    farmOptions.seed = parser.value("seed").toUInt();
+    const int hostCount = std::max(1, parser.value("hosts").toInt());
+
+    QTemporaryDir workDir;
+    TlsServerFarm* farm = new TlsServerFarm;
+    err << "Generating " << farmOptions.chains << " certificate chains" << Qt::endl;
+    if(!workDir.isValid() || !farm->generateChains(farmOptions.chains, workDir.path())) {
+        err << farm->errorString() << Qt::endl;
+        delete farm;
+        return 1;
+    }
+
+    // the endpoints get their own event loop, so serving does not slow down the client side
+    QThread farmThread;
+    farm->moveToThread(&farmThread);
+    QObject::connect(&farmThread, &QThread::finished, farm, &QObject::deleteLater);
+    farmThread.start();
+
+    bool started = false;
+    QMetaObject::invokeMethod(farm, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, started), Q_ARG(TlsServerFarm::Options, farmOptions));
+    if(!started) {
+        err << farm->errorString() << Qt::endl;
+        farmThread.quit();
+        farmThread.wait();
+        return 1;
+    }
+
+    const QStringList endpoints = farm->endpointHosts();
+    QStringList hostnames;
+    hostnames.reserve(hostCount);
+    for(int i = 0; i < hostCount; ++i)
+        hostnames.push_back(endpoints.at(i % endpoints.size()));
+    // the gatherer fetches every name once, only distinct names count
+    const int uniqueHosts = std::min(hostCount, int(endpoints.size()));
+    if(uniqueHosts < hostCount)
+        err << "Only " << uniqueHosts << " distinct hosts, raise --endpoints to scan " << hostCount << Qt::endl;
+
+    CAConcurrentGatherer gatherer;
+    gatherer.setCacheTtlHours(0); // every host must hit the network
+    gatherer.setConcurrency(parser.value("concurrency").toInt());
+    gatherer.setPerGroupConcurrency(parser.value("per-group").toInt());
+    gatherer.setAdaptiveConcurrency(!parser.isSet("fixed-concurrency"));
+    gatherer.setHandshakeOnly(parser.isSet("handshake-only"));
+    gatherer.setHostnames(hostnames);
+
+    QElapsedTimer timer;
+    QObject::connect(&gatherer, &CAConcurrentGatherer::busyChanged, &app, [&]() {
+        if(gatherer.busy())
+            return;
+
+        const qint64 elapsed = std::max<qint64>(1, timer.elapsed());
+        out << "hosts:        " << uniqueHosts << " on " << endpoints.size() << " endpoints ("
+            << farm->endpointCount(TlsServerFarm::Serve) << " serve, "
+            << farm->endpointCount(TlsServerFarm::Hang) << " hang, "
+            << farm->endpointCount(TlsServerFarm::Fail) << " fail)\n";
+        out << "mode:         " << (gatherer.handshakeOnly() ? "handshake only" : "HTTP GET")
+            << ", concurrency " << gatherer.concurrency();
+        if(gatherer.adaptiveConcurrency())
+            out << " adapted to " << gatherer.currentConcurrency();
+        out << '\n';
+        out << "elapsed:      " << elapsed << " ms\n";
+        out << "hosts/sec:    " << QString::number(uniqueHosts * 1000.0 / elapsed, 'f', 1) << '\n';
+        out << gatherer.metricsText();
+        out.flush();
+        app.quit();
+    });
+
+    err << "Scanning " << uniqueHosts << " hosts" << Qt::endl;
+    timer.start();
+    gatherer.startGatherCertificatesInBackground();
+    app.exec();
+
+    const int sequential = std::min(parser.value("sequential").toInt(), hostCount);
+    if(sequential > 0) {
+        ScanMetrics metrics;
+        const CertificateFetcher::Mode mode = gatherer.handshakeOnly() ? CertificateFetcher::HandshakeOnly : CertificateFetcher::HttpGet;
+        for(int i = 0; i < sequential; ++i) {
+            HostMetrics hostMetrics;
+            CAProcessor::getCertificate(hostnames.at(i), mode, &hostMetrics);
+            metrics.record(hostMetrics);
+        }
+        out << "\nBlocking getCertificate, " << sequential << " calls:\n" << metrics.summaryText();
+    }
+
+    out << "\npeak RSS:     " << peakRssKiB() / 1024 << " MiB" << Qt::endl;
+
+    QMetaObject::invokeMethod(farm, "stop", Qt::BlockingQueuedConnection);
+    farmThread.quit();
+    farmThread.wait();
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tlsserverfarm.h"
+
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QSslConfiguration>
+#include <QSslSocket>
+#include <QTimer>
+
+class TlsServerFarm::Endpoint : public QTcpServer
+{
+public:
+    Endpoint(Behavior behavior, const Chain& chain, int delayMs, int jitterMs, quint32 seed, QObject* parent)
+        : QTcpServer(parent), m_behavior(behavior), m_chain(chain),
+        m_delayMs(delayMs), m_jitterMs(jitterMs), m_random(seed)
+    {
+
+    }
+
+    Behavior behavior() const { return m_behavior; }
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        QSslSocket* socket = new QSslSocket(this);
+        if(!socket->setSocketDescriptor(socketDescriptor)) {
+            delete socket;
+            return;
+        }
+        connect(socket, &QSslSocket::disconnected, socket, &QObject::deleteLater);
+
+        if(m_behavior == Hang) {
+            // keep it open, the client gives up on its own
+            return;
+        }
+
+        if(m_behavior == Fail) {
+            socket->write("HTTP/1.0 400 Bad Request\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+
+        socket->setLocalCertificateChain(m_chain.certificates);
+        socket->setPrivateKey(m_chain.key);
+        socket->setPeerVerifyMode(QSslSocket::VerifyNone);
+        // answer any HTTP request right away, the client only wants the chain
+        connect(socket, &QSslSocket::readyRead, socket, [socket]() {
+            socket->readAll();
+            socket->write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+        });
+        connect(socket, &QSslSocket::sslErrors, socket, [socket]() { socket->ignoreSslErrors(); });
+
+        const int delay = m_delayMs + (m_jitterMs > 0 ? int(m_random.bounded(m_jitterMs + 1)) : 0);
+        if(delay > 0)
+            QTimer::singleShot(delay, socket, [socket]() { socket->startServerEncryption(); });
+        else
+            socket->startServerEncryption();
+    }
+
+private:
+    Behavior m_behavior;
+    Chain m_chain;
+    int m_delayMs;
+    int m_jitterMs;
+    QRandomGenerator m_random;
+};
+
+TlsServerFarm::TlsServerFarm(QObject *parent)
+    : QObject{parent}
+{
+    qRegisterMetaType<TlsServerFarm::Options>("TlsServerFarm::Options");
+}
+
+bool TlsServerFarm::runOpenSsl(const QStringList &arguments, const QString &workDir)
+{
+    QProcess openssl;
+    openssl.setWorkingDirectory(workDir);
+    openssl.setProcessChannelMode(QProcess::MergedChannels);
+    openssl.start("openssl", arguments);
+    if(!openssl.waitForFinished(30000) || openssl.exitStatus() != QProcess::NormalExit || openssl.exitCode() != 0) {
+        m_errorString = "openssl " + arguments.join(' ') + ": " + (openssl.error() == QProcess::FailedToStart ? openssl.errorString() : QString::fromLocal8Bit(openssl.readAll()));
+        return false;
+    }
+    return true;
+}
+
+bool TlsServerFarm::generateChains(int count, const QString &workDir)
+{
+    QDir dir(workDir);
+    if(!dir.mkpath(".")) {
+        m_errorString = "Can not create " + workDir;
+        return false;
+    }
+
+    const QStringList newKey = {"-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1", "-nodes"};
+    for(int i = 0; i < count; ++i) {
+        const QString n = QString::number(i);
+        const QString leafName = "bench-" + n + ".invalid";
+
+        QFile caExt(dir.filePath("ca.ext"));
+        QFile leafExt(dir.filePath("leaf" + n + ".ext"));
+        if(!caExt.open(QIODevice::WriteOnly) || !leafExt.open(QIODevice::WriteOnly)) {
+            m_errorString = "Can not write to " + workDir;
+            return false;
+        }
+        caExt.write("basicConstraints=critical,CA:TRUE\nkeyUsage=critical,keyCertSign,cRLSign\n");
+        leafExt.write("basicConstraints=CA:FALSE\nsubjectAltName=DNS:" + leafName.toUtf8() + "\n");
+        caExt.close();
+        leafExt.close();
+
+        if(!runOpenSsl(QStringList{"req", "-x509"} + newKey + QStringList{"-keyout", "root" + n + ".key", "-out", "root" + n + ".pem",
+                                                            "-days", "30", "-subj", "/O=CertInfo Benchmark/CN=Benchmark Root " + n,
+                                                            "-addext", "basicConstraints=critical,CA:TRUE"}, workDir)
+            || !runOpenSsl(QStringList{"req", "-new"} + newKey + QStringList{"-keyout", "int" + n + ".key", "-out", "int" + n + ".csr",
+                                                                "-subj", "/O=CertInfo Benchmark/CN=Benchmark Intermediate " + n}, workDir)
+            || !runOpenSsl({"x509", "-req", "-in", "int" + n + ".csr", "-CA", "root" + n + ".pem", "-CAkey", "root" + n + ".key",
+                            "-set_serial", "2", "-days", "30", "-extfile", "ca.ext", "-out", "int" + n + ".pem"}, workDir)
+            || !runOpenSsl(QStringList{"req", "-new"} + newKey + QStringList{"-keyout", "leaf" + n + ".key", "-out", "leaf" + n + ".csr",
+                                                                "-subj", "/CN=" + leafName}, workDir)
+            || !runOpenSsl({"x509", "-req", "-in", "leaf" + n + ".csr", "-CA", "int" + n + ".pem", "-CAkey", "int" + n + ".key",
+                            "-set_serial", "3", "-days", "30", "-extfile", "leaf" + n + ".ext", "-out", "leaf" + n + ".pem"}, workDir))
+            return false;
+
+        Chain chain;
+        for(const QString& name : {"leaf", "int", "root"}) {
+            const QList<QSslCertificate> certs = QSslCertificate::fromPath(dir.filePath(name + n + ".pem"));
+            if(certs.isEmpty()) {
+                m_errorString = "Can not read " + name + n + ".pem";
+                return false;
+            }
+            chain.certificates.push_back(certs.first());
+        }
+
+        QFile keyFile(dir.filePath("leaf" + n + ".key"));
+        if(keyFile.open(QIODevice::ReadOnly))
+            chain.key = QSslKey(keyFile.readAll(), QSsl::Ec);
+        if(chain.key.isNull()) {
+            m_errorString = "Can not read leaf" + n + ".key";
+            return false;
+        }
+        m_chains.push_back(chain);
+    }
+    return true;
+}
+
+bool TlsServerFarm::start(const TlsServerFarm::Options &options)
+{
+    if(m_chains.isEmpty()) {
+        m_errorString = "No certificate chains generated";
+        return false;
+    }
+
+    QRandomGenerator random(options.seed);
+    for(int i = 0; i < options.endpoints; ++i) {
+        const double roll = random.generateDouble();
+        Behavior behavior = Serve;
+        if(roll < options.hangRate)
+            behavior = Hang;
+        else if(roll < options.hangRate + options.failRate)
+            behavior = Fail;
+
+        Endpoint* endpoint = new Endpoint(behavior, m_chains.at(i % m_chains.size()), options.delayMs, options.jitterMs, random.generate(), this);
+        // 127.0.0.1 upwards, skipping .0 and .255 of every /24
+        const quint32 address = (127u << 24) + (quint32(i / 254) << 8) + quint32(i % 254) + 1;
+        if(!endpoint->listen(QHostAddress(address), 0)) {
+            m_errorString = "Can not listen on " + QHostAddress(address).toString() + ": " + endpoint->errorString();
+            delete endpoint;
+            stop();
+            return false;
+        }
+        m_endpoints.push_back(endpoint);
+    }
+    return true;
+}
+
+void TlsServerFarm::stop()
+{
+    qDeleteAll(m_endpoints);
+    m_endpoints.clear();
+}
+
+QStringList TlsServerFarm::endpointHosts() const
+{
+    QStringList result;
+    result.reserve(m_endpoints.size());
+    for(const Endpoint* endpoint : m_endpoints)
+        result.push_back(endpoint->serverAddress().toString() + ':' + QString::number(endpoint->serverPort()));
+    return result;
+}
+
+int TlsServerFarm::endpointCount(Behavior behavior) const
+{
+    return int(std::count_if(m_endpoints.cbegin(), m_endpoints.cend(), [behavior](const Endpoint* e) { return e->behavior() == behavior; }));
+}
+
+QString TlsServerFarm::errorString() const
+{
+    return m_errorString;
+}
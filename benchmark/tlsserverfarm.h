@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QStringList>
+#include <QTcpServer>
+
+/* Local TLS endpoints for the benchmark. Every endpoint listens on its
+ * own loopback address (127.0.x.y, Linux routes all of 127/8 to lo),
+ * so the gatherer sees distinct hosts, and serves one of a few generated
+ * root -> intermediate -> leaf chains.
+ *
+ * An endpoint either completes the handshake after an optional delay,
+ * hangs (accepts but never starts TLS, the client times out) or fails
+ * (answers plain text and closes, a TLS error on the client).
+ */
+class TlsServerFarm : public QObject
+{
+    Q_OBJECT
+public:
+    enum Behavior {
+        Serve,
+        Hang,
+        Fail
+    };
+
+    struct Options {
+        int endpoints = 64;
+        int chains = 8;
+        int delayMs = 0; // before the handshake starts
+        int jitterMs = 0; // random extra delay, 0..jitterMs
+        double hangRate = 0.0;
+        double failRate = 0.0;
+        quint32 seed = 1;
+    };
+
+    explicit TlsServerFarm(QObject *parent = nullptr);
+
+    // Generates the chains with the openssl command line tool in workDir.
+    bool generateChains(int count, const QString& workDir);
+    // Must run in the thread the farm lives in.
+    Q_INVOKABLE bool start(const TlsServerFarm::Options& options);
+    Q_INVOKABLE void stop();
+
+    // host:port of every endpoint, in endpoint order
+    QStringList endpointHosts() const;
+    int endpointCount(Behavior behavior) const;
+    QString errorString() const;
+
+private:
+    struct Chain {
+        QList<QSslCertificate> certificates; // leaf first
+        QSslKey key;
+    };
+
+    class Endpoint;
+    bool runOpenSsl(const QStringList& arguments, const QString& workDir);
+
+    QList<Chain> m_chains;
+    QList<Endpoint*> m_endpoints;
+    QString m_errorString;
+};
+
+Q_DECLARE_METATYPE(TlsServerFarm::Options)
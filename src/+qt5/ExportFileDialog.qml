@@ -3,11 +3,13 @@ import QtQuick.Dialogs 1.3
 
 FileDialog {
     required property var proc
+    // PEM bodies in .jsonl and .csv exports, they make up most of the size
+    property bool includePem: false
     id: root
     title: "Export results to which file"
     selectExisting: false
-    nameFilters: [ "text file (*.txt)", "All files (*)" ]
+    nameFilters: [ "text file (*.txt)", "JSON Lines (*.jsonl)", "CSV (*.csv)", "All files (*)" ]
     onAccepted: {
-        proc.exportToText(root.fileUrl)
+        proc.exportToFile(root.fileUrl, root.includePem)
     }
 }
@@ -3,11 +3,13 @@ import QtQuick.Dialogs
 
 FileDialog {
     required property var proc
+    // PEM bodies in .jsonl and .csv exports, they make up most of the size
+    property bool includePem: false
     id: root
     title: "Export results to which file"
     fileMode: FileDialog.SaveFile
-    nameFilters: [ "text file (*.txt)", "All files (*)" ]
+    nameFilters: [ "text file (*.txt)", "JSON Lines (*.jsonl)", "CSV (*.csv)", "All files (*)" ]
     onAccepted: {
-        proc.exportToText(root.selectedFile)
+        proc.exportToFile(root.selectedFile, root.includePem)
     }
 }
@@ -17,6 +17,15 @@
 
 #include "caconcurrentgatherer.h"
 #include "caprocessor.h"
+#include "scanscheduler.h"
+#include "concurrencycontroller.h"
+#include "hostresolver.h"
+#include "certificatefetcher.h"
+#include "truststore.h"
+#include "certificateinterntable.h"
+#include "scancache.h"
+#include "scancheckpoint.h"
+#include "scanresultwriter.h"
 
 #include <iostream>
 #include <algorithm>
@@ -25,9 +34,10 @@
 #include <QApplication>
 #include <QSslSocket>
 #include <QtConcurrent/QtConcurrent>
-#include <QThreadPool>
-#include <QSslConfiguration>
+#include <QThread>
 #include <QFuture>
+#include <QScopedPointer>
+#include <QSet>
 #include <QCoreApplication>
 
 CAConcurrentGatherer::CAConcurrentGatherer(QObject *parent)
@@ -39,13 +49,25 @@ CAConcurrentGatherer::CAConcurrentGatherer(QObject *parent)
      * QObject::connect: Cannot queue arguments of type 'QQmlChangeSet'
      * (Make sure 'QQmlChangeSet' is registered using qRegisterMetaType().)
      */
-    connect(this, &CAConcurrentGatherer::threadBucketFinished, this, &CAConcurrentGatherer::onThreadBucketFinished, Qt::QueuedConnection);
+    qRegisterMetaType<QList<Certificate>>("QList<Certificate>");
+    qRegisterMetaType<HostMetrics>("HostMetrics");
+    connect(this, &CAConcurrentGatherer::partialResultsReady, this, &CAConcurrentGatherer::onPartialResultsReady, Qt::QueuedConnection);
     connect(this, &CAConcurrentGatherer::allThreadsFinished, this, &CAConcurrentGatherer::onAllThreadsFinished, Qt::QueuedConnection);
     connect(this, &CAConcurrentGatherer::privateProgressChanged, this, &CAConcurrentGatherer::setProgress, Qt::QueuedConnection);
+    connect(this, &CAConcurrentGatherer::privateConcurrencyChanged, this, &CAConcurrentGatherer::setCurrentConcurrency, Qt::QueuedConnection);
+    if(QCoreApplication::instance())
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() { setStop(true); });
 
     setPrivateProgress(0);
+}
 
-    _systemCerts = QSslConfiguration::systemCaCertificates();
+CAConcurrentGatherer::~CAConcurrentGatherer()
+{
+    // the window may close mid-scan, the scan (and its last checkpoint)
+    // has to finish before the members go
+    setStop(true);
+    m_scan.waitForFinished();
+    m_checkpointSave.waitForFinished();
 }
 
 void CAConcurrentGatherer::clear()
@@ -53,6 +75,7 @@ void CAConcurrentGatherer::clear()
     if(!busy()) {
         setHostnames({});
         m_issuersCounted->clear();
+        CertificateInternTable::instance().clear();
     }
 }
 
@@ -73,9 +96,9 @@ void CAConcurrentGatherer::startGatherCertificatesInBackground()
     }
 
     setBusy(true);
-    QtConcurrent::run([this]() {
-        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [&](){setStop(true);});
-        m_issuersCounted->clear();        
+    // the model keeps a row index, reset it on the thread that owns it
+    m_issuersCounted->clear();
+    m_scan = QtConcurrent::run([this]() {
         setPrivateProgress(0);
         gatherCertificates();
     });
@@ -102,12 +125,15 @@ void CAConcurrentGatherer::exportToText(const QUrl &path)
         }
         stream << "==============================\n\n";
 
+        stream << "Scan timings: \n\n";
+        stream << m_metrics.summaryText();
+        stream << "==============================\n\n";
+
         stream << "Certificates found in this scan: \n";
         stream << "==============================\n\n";
         QList<Certificate> result;
-        QHash<QString, Certificate>::iterator i;
-        for(i = resultHash.begin(); i != resultHash.end(); ++i)
-            result.push_back(i.value());
+        for(const CertificateAggregate& aggregate : qAsConst(resultHash))
+            result.push_back(toCertificate(aggregate));
 
         std::sort(result.begin(), result.end(), [](const Certificate& a, const Certificate& b) { return a.count > b.count; });
 
@@ -122,64 +148,415 @@ void CAConcurrentGatherer::exportToText(const QUrl &path)
 
 }
 
-void CAConcurrentGatherer::gatherCertificates()
+void CAConcurrentGatherer::exportToFile(const QUrl &path, bool includePem)
 {
-    resultHash.clear();
+    if(busy())
+        return;
 
-    int bucketSize = 10;
-    int totalSize = m_hostnames.size();
-    int amountOfBuckets = (totalSize ) / bucketSize;
-    int currentCounter = 0;
-    if(amountOfBuckets < 1) {
-        amountOfBuckets = 1;
-        bucketSize = totalSize;
+    const QString fileName = path.toLocalFile();
+    if(!fileName.endsWith(".jsonl", Qt::CaseInsensitive) && !fileName.endsWith(".csv", Qt::CaseInsensitive)) {
+        exportToText(path);
+        return;
     }
 
-    QThreadPool pool;
-    for(int i = 0; i < amountOfBuckets; ++i) {
-        if(m_stop)
-            break;
-
-        // gather the certificates concurrently, but only 10 at once
-        QFutureSynchronizer<QList<Certificate>> synchronizer;
-        int thisBucketEndsAt = bucketSize + currentCounter;
-        setStatusText("Checking domains " + QString::number(currentCounter) + " to " + QString::number(thisBucketEndsAt) + " (of " + QString::number(m_hostnames.size()) + ")");
-        for(int j = currentCounter; j < thisBucketEndsAt; ++j) {
-            synchronizer.addFuture(QtConcurrent::run(&pool, CAProcessor::getCertificate, m_hostnames.at(currentCounter)));
-            ++currentCounter;
+    ScanResultWriter writer(ScanResultWriter::formatForPath(fileName), includePem);
+    if(!writer.open(fileName)) {
+        setStatusText("Export failed: " + writer.errorString());
+        return;
+    }
+    for(const CertificateAggregate& aggregate : qAsConst(resultHash))
+        writer.writeCertificate(toCertificate(aggregate));
+    writer.close();
+}
+
+void CAConcurrentGatherer::clearScanCache()
+{
+    if(busy())
+        return;
+
+    ScanCache cache;
+    if(!cache.open() || !cache.clear())
+        setStatusText("Could not clear the scan cache: " + cache.lastError());
+    else
+        setStatusText("Scan cache cleared");
+}
+
+bool CAConcurrentGatherer::resumeFromCheckpoint()
+{
+    if(busy())
+        return false;
+
+    ScanCheckpoint::State state;
+    if(!ScanCheckpoint::load(state)) {
+        setStatusText("No usable checkpoint to resume from");
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_resultMutex);
+        resultHash = state.results;
+        m_domainNames = state.domainNames;
+        m_domainIds.clear();
+        for(int i = 0; i < m_domainNames.size(); ++i)
+            m_domainIds.insert(m_domainNames.at(i), i);
+        m_hostsCompleted = state.completed;
+        // publish everything that was already found
+        m_dirty.clear();
+        for(auto it = resultHash.constBegin(); it != resultHash.constEnd(); ++it)
+            m_dirty.insert(it.key());
+    }
+    setHostnames(state.hostnames);
+
+    m_resume = true;
+    startGatherCertificatesInBackground();
+    if(!busy()) {
+        m_resume = false;
+        return false;
+    }
+    return true;
+}
+
+void CAConcurrentGatherer::discardCheckpoint()
+{
+    if(busy())
+        return;
+    ScanCheckpoint::remove();
+    emit hasCheckpointChanged();
+}
+
+bool CAConcurrentGatherer::hasCheckpoint() const
+{
+    return ScanCheckpoint::exists();
+}
+
+QVariantMap CAConcurrentGatherer::metrics() const
+{
+    return m_metrics.summary();
+}
+
+QString CAConcurrentGatherer::metricsText() const
+{
+    return m_metrics.summaryText();
+}
+
+void CAConcurrentGatherer::writeCheckpoint(bool inBackground)
+{
+    // one save at a time, a background save still running skips this one
+    if(inBackground && m_checkpointSaving.exchange(true))
+        return;
+
+    // snapshot under the lock, the copies are implicitly shared and cheap
+    ScanCheckpoint::State state;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        state.hostnames = m_hostnames;
+        state.completed = m_hostsCompleted;
+        state.domainNames = m_domainNames;
+        state.results = resultHash;
+    }
+
+    if(!inBackground) {
+        if(!ScanCheckpoint::save(state))
+            qWarning() << "Could not write scan checkpoint to" << ScanCheckpoint::defaultPath();
+        return;
+    }
+
+    // serializing and writing to disk would stall all handshakes
+    m_checkpointSave = QtConcurrent::run([this, state]() {
+        if(!ScanCheckpoint::save(state))
+            qWarning() << "Could not write scan checkpoint to" << ScanCheckpoint::defaultPath();
+        m_checkpointSaving = false;
+    });
+}
+
+void CAConcurrentGatherer::gatherCertificates()
+{
+    QStringList pending;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        if(!m_resume) {
+            resultHash.clear();
+            m_dirty.clear();
+            m_domainIds.clear();
+            m_domainNames.clear();
+            m_hostsCompleted = QBitArray(m_hostnames.size());
         }
-        synchronizer.waitForFinished();
-
-        QList<QFuture<QList<Certificate>>> futures = synchronizer.futures();
-        for(int i = 0; i < futures.count(); ++i) {
-            QList<Certificate> rV = futures.at(i).result();
-            for(Certificate& r : rV) {
-                if(resultHash.contains(r.subject)) {
-                    for(const auto& d : qAsConst(r.domains))
-                        resultHash[r.subject].domains.push_back(d);
-                } else {
-                    resultHash[r.subject] = r;
-                }
-                ++resultHash[r.subject].count;
+        m_hostIndex.clear();
+        m_hostIndex.reserve(m_hostnames.size());
+        for(int i = 0; i < m_hostnames.size(); ++i) {
+            QList<int>& indices = m_hostIndex[m_hostnames.at(i)];
+            indices.push_back(i);
+            // a name listed twice is fetched once, its result marks both
+            if(indices.size() == 1 && !m_hostsCompleted.testBit(i))
+                pending.push_back(m_hostnames.at(i));
+        }
+        m_hostsDone = m_hostsCompleted.count(true);
+        m_lastPublish.start();
+        m_lastCheckpoint.start();
+        // anything appended so far is in m_hostnames already
+        m_incoming.clear();
+    }
+    m_resume = false;
+    m_metrics.clear();
+
+    // recently fetched hosts are served from disk, only the rest hits the network
+    QStringList toFetch = pending;
+    QScopedPointer<ScanCache> cache;
+    if(cacheTtlHours() > 0) {
+        cache.reset(new ScanCache);
+        if(cache->open()) {
+            const QHash<QString, QList<Certificate>> cached = cache->load(pending, qint64(cacheTtlHours()) * 3600);
+            toFetch.clear();
+            for(const QString& hostname : qAsConst(pending)) {
+                auto it = cached.constFind(hostname);
+                if(it != cached.constEnd())
+                    mergeHostResult(hostname, it.value());
+                else
+                    toFetch.push_back(hostname);
             }
+        } else {
+            qWarning() << "Scan cache unavailable:" << cache->lastError();
+            cache.reset();
         }
+    }
 
+    // sliding window: the next domain starts as soon as any slot frees up,
+    // so one slow host no longer holds up the others. Hosts are grouped
+    // by IP address, so names sharing a server take turns with the rest.
+    ScanScheduler scheduler(concurrency(), perGroupConcurrency());
+    scheduler.openInput();
+    ConcurrencyController controller(concurrency());
+    const bool adaptive = adaptiveConcurrency();
+    emit privateConcurrencyChanged(scheduler.concurrency());
+    setStatusText("Checking " + QString::number(toFetch.size()) + " domains, " + QString::number(scheduler.concurrency()) + " at once, "
+                  + QString::number(pending.size() - toFetch.size()) + " from cache");
+
+    // all requests are driven from one event loop thread, so the window
+    // size is no longer bound by the number of pool threads.
+    QThread fetcherThread;
+    CertificateFetcher* fetcher = new CertificateFetcher;
+    fetcher->setMode(handshakeOnly() ? CertificateFetcher::HandshakeOnly : CertificateFetcher::HttpGet);
+    fetcher->moveToThread(&fetcherThread);
+    connect(&fetcherThread, &QThread::finished, fetcher, &QObject::deleteLater);
+
+    // DNS runs ahead of the TLS stage, dead domains never take a TLS slot
+    HostResolver* resolver = new HostResolver;
+    resolver->enqueue(toFetch);
+    if(handshakeOnly()) {
+        resolver->setGate([&scheduler]() { return scheduler.queued() < std::max(64, scheduler.concurrency() * 4); });
+    } else {
+        // HTTP mode only gains from the lookup when QNAM finds it in Qt's
+        // host cache, which holds 128 names for 60 seconds. Keep the hosts
+        // resolved but not yet fetched well below that.
+        resolver->setMaxPending(32);
+        resolver->setGate([&scheduler]() { return scheduler.queued() < 64; });
+    }
+    resolver->moveToThread(&fetcherThread);
+    connect(&fetcherThread, &QThread::finished, resolver, &QObject::deleteLater);
+    // addresses per host until its fetch starts, only used on the fetcher thread
+    QHash<QString, QStringList> addresses;
+    connect(resolver, &HostResolver::resolved, resolver, [this, &scheduler, &addresses](const QString& hostname, const QList<QHostAddress>& resolved, qint64 elapsedMs) {
+        m_metrics.recordDns(elapsedMs);
+        if(resolved.isEmpty()) {
+            scheduler.enqueue(hostname, ScanScheduler::registrableDomain(hostname));
+            return;
+        }
+        QStringList& list = addresses[hostname];
+        for(const QHostAddress& address : resolved)
+            list.push_back(address.toString());
+        scheduler.enqueue(hostname, list.first());
+    }, Qt::DirectConnection);
+    connect(resolver, &HostResolver::notFound, resolver, [this](const QString& hostname, const QString& errorString, qint64 elapsedMs) {
+        HostMetrics metrics;
+        metrics.domain = hostname;
+        metrics.outcome = HostMetrics::NetworkError;
+        metrics.errorName = QStringLiteral("HostNotFoundError");
+        metrics.totalMs = elapsedMs;
+        m_metrics.recordDns(elapsedMs);
+        m_metrics.record(metrics);
+        mergeHostResult(hostname, {CAProcessor::errorCertificate(hostname, errorString)});
+    }, Qt::DirectConnection);
+    connect(resolver, &HostResolver::drained, resolver, [&scheduler]() { scheduler.closeInput(); }, Qt::DirectConnection);
+    // more hosts may come in through appendHostnames() until hostnamesComplete
+    resolver->openInput();
+    {
+        QMutexLocker locker(&m_resultMutex);
+        m_resolver = resolver;
+        m_scheduler = &scheduler;
+    }
 
-        int currentPercent = ((double)currentCounter*100/(double)totalSize);
-        setPrivateProgress(currentPercent);
-        emit threadBucketFinished();
+    connect(fetcher, &CertificateFetcher::measured, fetcher, [this, &scheduler, &controller, adaptive](const HostMetrics& metrics) {
+        m_metrics.record(metrics);
+        if(!adaptive)
+            return;
+        const int limit = controller.record(metrics);
+        if(limit != scheduler.concurrency()) {
+            scheduler.setConcurrency(limit);
+            emit privateConcurrencyChanged(limit);
+        }
+    }, Qt::DirectConnection);
+    ScanCache* cachePtr = cache.data();
+    connect(fetcher, &CertificateFetcher::finished, fetcher, [this, &scheduler, cachePtr, resolver](const QString& hostname, const QList<Certificate>& result) {
+        mergeHostResult(hostname, result);
+        if(cachePtr)
+            cachePtr->store(hostname, result);
+        scheduler.finish(hostname);
+        if(m_stop)
+            scheduler.stop();
+        else
+            resolver->pump(); // the queue shrank, resolve some more
+    }, Qt::DirectConnection);
+    fetcherThread.start();
+    wakeResolver();
+
+    QString hostname;
+    while(!m_stop && scheduler.takeNext(hostname)) {
+        // runs on the fetcher thread, next to the resolver that filled addresses
+        QMetaObject::invokeMethod(fetcher, [fetcher, hostname, &addresses]() {
+            fetcher->fetch(hostname, addresses.take(hostname));
+        }, Qt::QueuedConnection);
     }
+    scheduler.waitForIdle();
+
+    {
+        QMutexLocker locker(&m_resultMutex);
+        m_resolver = nullptr;
+        m_scheduler = nullptr;
+    }
+    fetcherThread.quit();
+    fetcherThread.wait();
+    m_checkpointSave.waitForFinished();
+
+    if(cache && !cache->commit())
+        qWarning() << "Could not write the scan cache:" << cache->lastError();
+    // entries older than the TTL are of no use anymore
+    if(cache && !cache->prune(qint64(cacheTtlHours()) * 3600))
+        qWarning() << "Could not prune the scan cache:" << cache->lastError();
+
+    // an interrupted scan can be resumed, a finished one needs no checkpoint
+    if(m_stop)
+        writeCheckpoint();
+    else
+        ScanCheckpoint::remove();
 
     emit allThreadsFinished();
 }
 
-void CAConcurrentGatherer::checkNonInUseSystemRootCAs()
+void CAConcurrentGatherer::feedResolver()
 {
-    for(const Certificate& cert : qAsConst(resultList)){
-        _systemCerts.erase(std::remove_if(_systemCerts.begin(), _systemCerts.end(), [&cert](const QSslCertificate& c){return cert._actualCert == c; }), _systemCerts.end());
+    // runs on the fetcher thread, next to the resolver
+    QStringList incoming;
+    HostResolver* resolver = nullptr;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        resolver = m_resolver;
+        incoming.swap(m_incoming);
+    }
+    if(!resolver)
+        return;
+
+    resolver->enqueue(incoming);
+    if(m_hostnamesComplete || m_stop)
+        resolver->closeInput();
+    else
+        resolver->pump();
+}
+
+void CAConcurrentGatherer::wakeResolver()
+{
+    QMutexLocker locker(&m_resultMutex);
+    if(m_resolver)
+        QMetaObject::invokeMethod(m_resolver, [this]() { feedResolver(); }, Qt::QueuedConnection);
+}
+
+void CAConcurrentGatherer::mergeHostResult(const QString &hostname, const QList<Certificate> &certificates)
+{
+    emit hostFinished(hostname, certificates);
+
+    QMutexLocker locker(&m_resultMutex);
+    for(const Certificate& r : certificates) {
+        CertificateAggregate& aggregate = resultHash[r.digest];
+        if(!aggregate.certificate) {
+            aggregate.certificate = CertificateInternTable::instance().find(r.digest);
+            if(!aggregate.certificate) {
+                // errors are not interned, keep a copy without the attribution
+                Certificate c = r;
+                c.domains.clear();
+                aggregate.certificate = QSharedPointer<Certificate>::create(c);
+            }
+        }
+        for(const auto& d : qAsConst(r.domains))
+            aggregate.domainIds.insert(domainId(d));
+        ++aggregate.count;
+        m_dirty.insert(r.digest);
+    }
+
+    auto indices = m_hostIndex.constFind(hostname);
+    if(indices != m_hostIndex.constEnd()) {
+        for(int hostIndex : *indices) {
+            if(!m_hostsCompleted.testBit(hostIndex)) {
+                m_hostsCompleted.setBit(hostIndex);
+                ++m_hostsDone;
+            }
+        }
+    } else {
+        ++m_hostsDone;
     }
+    int totalSize = m_hostnames.size();
+    int currentPercent = totalSize > 0 ? ((double)m_hostsDone*100/(double)totalSize) : 100;
+    setPrivateProgress(currentPercent);
+
+    // don't flood the UI thread, publish at most a few times per second
+    if(m_lastPublish.elapsed() >= 250) {
+        m_lastPublish.restart();
+        setStatusText("Checked " + QString::number(m_hostsDone) + " of " + QString::number(totalSize) + " domains");
+        emit partialResultsReady();
+    }
+
+    if(m_lastCheckpoint.elapsed() >= 30000) {
+        m_lastCheckpoint.restart();
+        locker.unlock();
+        writeCheckpoint(true);
+    }
+}
+
+Certificate CAConcurrentGatherer::toCertificate(const CertificateAggregate &aggregate) const
+{
+    Certificate result = *aggregate.certificate;
+    result.count = aggregate.count;
+
+    // ids are handed out in order of first appearance
+    QList<int> ids = aggregate.domainIds.values();
+    std::sort(ids.begin(), ids.end());
+    result.domains.clear();
+    result.domains.reserve(ids.size());
+    for(int id : qAsConst(ids))
+        result.domains.push_back(m_domainNames.at(id));
+
+    return result;
+}
+
+int CAConcurrentGatherer::domainId(const QString &domain)
+{
+    auto it = m_domainIds.constFind(domain);
+    if(it != m_domainIds.constEnd())
+        return it.value();
+
+    int id = m_domainNames.size();
+    m_domainNames.push_back(domain);
+    m_domainIds.insert(domain, id);
+    return id;
+}
+
+void CAConcurrentGatherer::checkNonInUseSystemRootCAs()
+{
+    QMutexLocker locker(&m_resultMutex);
+
+    _notInUseSystemRootCAList.clear();
+    for(const QSslCertificate& cert : TrustStore::system().certificates()) {
+        if(resultHash.contains(TrustStore::digestOf(cert)))
+            continue;
 
-    for(const QSslCertificate& cert : qAsConst(_systemCerts)) {
         Certificate rootCert = CAProcessor::parseQSslCertificateToCertificate(cert);
         rootCert.isSystemTrustedRootCA = true;
         _notInUseSystemRootCAList.push_back(rootCert);
@@ -195,27 +572,31 @@ void CAConcurrentGatherer::onAllThreadsFinished()
     setStatusText("Finished all domains");
     setPrivateProgress(100);
 
+    onPartialResultsReady();
     checkNonInUseSystemRootCAs();
 
+    emit hasCheckpointChanged();
+
     QApplication::alert(nullptr, 0);
 
     setBusy(false);
     setStop(false);
 }
 
-void CAConcurrentGatherer::onThreadBucketFinished()
+void CAConcurrentGatherer::onPartialResultsReady()
 {
-
-    resultList.clear();
-
-    QHash<QString, Certificate>::iterator i;
-    for(i = resultHash.begin(); i != resultHash.end(); ++i)
-        resultList.push_back(i.value());
-
-    for(const Certificate& c : resultList) {
-        m_issuersCounted->addOrUpdateItem(c, c.subject);
+    // only the certificates that changed since the last publish
+    QList<Certificate> changed;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        changed.reserve(m_dirty.size());
+        for(const QByteArray& digest : qAsConst(m_dirty))
+            changed.push_back(toCertificate(resultHash.value(digest)));
+        m_dirty.clear();
     }
 
+    m_issuersCounted->addOrUpdateItems(changed);
+    emit metricsChanged();
 }
 
 
@@ -241,12 +622,58 @@ QStringList CAConcurrentGatherer::hostnames() const
 
 void CAConcurrentGatherer::setHostnames(const QStringList &newHostnames)
 {
-    if (m_hostnames == newHostnames)
+    // the running scan owns the list, it only grows through appendHostnames()
+    if (busy() || m_hostnames == newHostnames)
         return;
     m_hostnames = newHostnames;
     emit hostnamesChanged();
 }
 
+void CAConcurrentGatherer::appendHostnames(const QStringList &newHostnames)
+{
+    if(newHostnames.isEmpty())
+        return;
+
+    {
+        QMutexLocker locker(&m_resultMutex);
+        const int first = m_hostnames.size();
+        m_hostnames.append(newHostnames);
+        if(busy()) {
+            m_hostsCompleted.resize(m_hostnames.size());
+            for(int i = first; i < m_hostnames.size(); ++i) {
+                QList<int>& indices = m_hostIndex[m_hostnames.at(i)];
+                indices.push_back(i);
+                if(indices.size() > 1) {
+                    // already queued, or done and only needs marking
+                    if(m_hostsCompleted.testBit(indices.first())) {
+                        m_hostsCompleted.setBit(i);
+                        ++m_hostsDone;
+                    }
+                    continue;
+                }
+                // late hosts skip the scan cache, it lives on the scan thread
+                m_incoming.push_back(m_hostnames.at(i));
+            }
+        }
+    }
+    wakeResolver();
+    emit hostnamesChanged();
+}
+
+bool CAConcurrentGatherer::hostnamesComplete() const
+{
+    return m_hostnamesComplete;
+}
+
+void CAConcurrentGatherer::setHostnamesComplete(bool newHostnamesComplete)
+{
+    if (m_hostnamesComplete == newHostnamesComplete)
+        return;
+    m_hostnamesComplete = newHostnamesComplete;
+    wakeResolver();
+    emit hostnamesCompleteChanged();
+}
+
 CACertificateListModel *CAConcurrentGatherer::issuersCounted() const
 {
     return m_issuersCounted;
@@ -307,5 +734,92 @@ void CAConcurrentGatherer::setStop(bool newStop)
         return;
 
     m_stop = newStop;
+    if(newStop) {
+        wakeResolver(); // stop waiting for more hosts
+        QMutexLocker locker(&m_resultMutex);
+        if(m_scheduler)
+            m_scheduler->stop(); // no more hosts handed out, in-flight ones finish
+    }
     emit stopChanged();
 }
+
+int CAConcurrentGatherer::concurrency() const
+{
+    return m_concurrency;
+}
+
+void CAConcurrentGatherer::setConcurrency(int newConcurrency)
+{
+    newConcurrency = std::max(1, newConcurrency);
+    if (m_concurrency == newConcurrency)
+        return;
+    m_concurrency = newConcurrency;
+    emit concurrencyChanged();
+}
+
+bool CAConcurrentGatherer::handshakeOnly() const
+{
+    return m_handshakeOnly;
+}
+
+void CAConcurrentGatherer::setHandshakeOnly(bool newHandshakeOnly)
+{
+    if (m_handshakeOnly == newHandshakeOnly)
+        return;
+    m_handshakeOnly = newHandshakeOnly;
+    emit handshakeOnlyChanged();
+}
+
+int CAConcurrentGatherer::cacheTtlHours() const
+{
+    return m_cacheTtlHours;
+}
+
+void CAConcurrentGatherer::setCacheTtlHours(int newCacheTtlHours)
+{
+    newCacheTtlHours = std::max(0, newCacheTtlHours);
+    if (m_cacheTtlHours == newCacheTtlHours)
+        return;
+    m_cacheTtlHours = newCacheTtlHours;
+    emit cacheTtlHoursChanged();
+}
+
+int CAConcurrentGatherer::perGroupConcurrency() const
+{
+    return m_perGroupConcurrency;
+}
+
+void CAConcurrentGatherer::setPerGroupConcurrency(int newPerGroupConcurrency)
+{
+    newPerGroupConcurrency = std::max(1, newPerGroupConcurrency);
+    if (m_perGroupConcurrency == newPerGroupConcurrency)
+        return;
+    m_perGroupConcurrency = newPerGroupConcurrency;
+    emit perGroupConcurrencyChanged();
+}
+
+bool CAConcurrentGatherer::adaptiveConcurrency() const
+{
+    return m_adaptiveConcurrency;
+}
+
+void CAConcurrentGatherer::setAdaptiveConcurrency(bool newAdaptiveConcurrency)
+{
+    if (m_adaptiveConcurrency == newAdaptiveConcurrency)
+        return;
+    m_adaptiveConcurrency = newAdaptiveConcurrency;
+    emit adaptiveConcurrencyChanged();
+}
+
+int CAConcurrentGatherer::currentConcurrency() const
+{
+    return m_currentConcurrency;
+}
+
+void CAConcurrentGatherer::setCurrentConcurrency(int newCurrentConcurrency)
+{
+    if (m_currentConcurrency == newCurrentConcurrency)
+        return;
+    m_currentConcurrency = newCurrentConcurrency;
+    emit currentConcurrencyChanged();
+}
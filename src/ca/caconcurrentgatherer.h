@@ -17,38 +17,80 @@
 #pragma once
 
 #include "src/listmodel/caissuerlistmodel.h"
+#include "scanmetrics.h"
 
 #include <atomic>
+#include <QBitArray>
 #include <QMutex>
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QString>
 #include <QMap>
 #include <QObject>
 #include <QSslCertificate>
+#include <QSet>
+#include <QSharedPointer>
 
 typedef QPair<QString,int> QIntPair;
 
+class HostResolver;
+class ScanScheduler;
+
+// One entry per unique certificate (or error) found in a scan.
+struct CertificateAggregate {
+    QSharedPointer<const Certificate> certificate;
+    int count = 0;
+    QSet<int> domainIds;
+};
+
 class CAConcurrentGatherer : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool stop READ stop WRITE setStop NOTIFY stopChanged FINAL)
     Q_PROPERTY(QStringList hostnames READ hostnames WRITE setHostnames NOTIFY hostnamesChanged FINAL)
+    Q_PROPERTY(bool hostnamesComplete READ hostnamesComplete WRITE setHostnamesComplete NOTIFY hostnamesCompleteChanged FINAL)
     Q_PROPERTY(CACertificateListModel* issuersCounted READ issuersCounted NOTIFY issuersCountedChanged FINAL)
     Q_PROPERTY(CACertificateListModel* notInUseSystemRootCAs READ notInUseSystemRootCAs NOTIFY notInUseSystemRootCAsChanged FINAL)
     Q_PROPERTY(bool busy READ busy WRITE setBusy NOTIFY busyChanged FINAL)
     Q_PROPERTY(QString statusText READ statusText WRITE setStatusText NOTIFY statusTextChanged FINAL)
     Q_PROPERTY(int progress READ progress WRITE setProgress NOTIFY progressChanged FINAL)
     Q_PROPERTY(int privateProgress READ privateProgress WRITE setPrivateProgress NOTIFY privateProgressChanged FINAL)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency NOTIFY concurrencyChanged FINAL)
+    Q_PROPERTY(int perGroupConcurrency READ perGroupConcurrency WRITE setPerGroupConcurrency NOTIFY perGroupConcurrencyChanged FINAL)
+    Q_PROPERTY(bool adaptiveConcurrency READ adaptiveConcurrency WRITE setAdaptiveConcurrency NOTIFY adaptiveConcurrencyChanged FINAL)
+    Q_PROPERTY(int currentConcurrency READ currentConcurrency WRITE setCurrentConcurrency NOTIFY currentConcurrencyChanged FINAL)
+    Q_PROPERTY(bool handshakeOnly READ handshakeOnly WRITE setHandshakeOnly NOTIFY handshakeOnlyChanged FINAL)
+    Q_PROPERTY(int cacheTtlHours READ cacheTtlHours WRITE setCacheTtlHours NOTIFY cacheTtlHoursChanged FINAL)
+    Q_PROPERTY(bool hasCheckpoint READ hasCheckpoint NOTIFY hasCheckpointChanged FINAL)
+    // latency percentiles per phase and outcome counts of the last scan, see ScanMetrics::summary()
+    Q_PROPERTY(QVariantMap metrics READ metrics NOTIFY metricsChanged FINAL)
 
 public:
     explicit CAConcurrentGatherer(QObject *parent = nullptr);
+    // stops a running scan and waits for it, it uses this until it returns
+    ~CAConcurrentGatherer();
 
     Q_INVOKABLE void clear();
     Q_INVOKABLE void startGatherCertificatesInBackground();
     Q_INVOKABLE void exportToText(const QUrl& path);
+    // .jsonl or .csv go through ScanResultWriter, anything else is text
+    Q_INVOKABLE void exportToFile(const QUrl& path, bool includePem = false);
+    Q_INVOKABLE void clearScanCache();
+    // Continue an interrupted scan from the last checkpoint, already
+    // finished hosts and their results are kept.
+    Q_INVOKABLE bool resumeFromCheckpoint();
+    Q_INVOKABLE void discardCheckpoint();
+    // Hosts added while a scan runs are picked up by that scan.
+    Q_INVOKABLE void appendHostnames(const QStringList& newHostnames);
 
     QStringList hostnames() const;
     void setHostnames(const QStringList &newHostnames);
 
+    // false while a source is still reading, the scan then waits for
+    // appendHostnames() instead of finishing when it runs out of hosts
+    bool hostnamesComplete() const;
+    void setHostnamesComplete(bool newHostnamesComplete);
+
     CACertificateListModel *issuersCounted() const;
 
     CACertificateListModel *notInUseSystemRootCAs() const;
@@ -68,10 +110,39 @@ public:
     bool stop() const;
     void setStop(bool newStop);
 
+    // with adaptiveConcurrency this is only where the scan starts
+    int concurrency() const;
+    void setConcurrency(int newConcurrency);
+
+    // at most this many hosts on one IP address (registrable domain if unresolved) at once
+    int perGroupConcurrency() const;
+    void setPerGroupConcurrency(int newPerGroupConcurrency);
+
+    bool adaptiveConcurrency() const;
+    void setAdaptiveConcurrency(bool newAdaptiveConcurrency);
+
+    // hosts allowed in flight right now
+    int currentConcurrency() const;
+    void setCurrentConcurrency(int newCurrentConcurrency);
+
+    bool handshakeOnly() const;
+    void setHandshakeOnly(bool newHandshakeOnly);
+
+    // hosts fetched less than this long ago come from the scan cache, 0 disables it
+    int cacheTtlHours() const;
+    void setCacheTtlHours(int newCacheTtlHours);
+
+    bool hasCheckpoint() const;
+
+    QVariantMap metrics() const;
+    QString metricsText() const;
+
 signals:
     void hostnamesChanged();    
+    void hostnamesCompleteChanged();
     void issuersCountedChanged();
-    void threadBucketFinished();
+    void hostFinished(const QString& hostname, const QList<Certificate>& certificates);
+    void partialResultsReady();
     void allThreadsFinished();
     void busyChanged();
     void statusTextChanged();
@@ -79,26 +150,64 @@ signals:
     void privateProgressChanged(int newProgress);
     void notInUseSystemRootCAsChanged();
     void stopChanged();
+    void concurrencyChanged();
+    void perGroupConcurrencyChanged();
+    void adaptiveConcurrencyChanged();
+    void currentConcurrencyChanged();
+    void privateConcurrencyChanged(int newConcurrency);
+    void handshakeOnlyChanged();
+    void cacheTtlHoursChanged();
+    void hasCheckpointChanged();
+    void metricsChanged();
 
 private slots:
-    void onThreadBucketFinished();
+    void onPartialResultsReady();
     void onAllThreadsFinished();
 
 private:
     bool _busy = false;
     QStringList m_hostnames;
     void gatherCertificates();
+    void mergeHostResult(const QString& hostname, const QList<Certificate>& certificates);
+    Certificate toCertificate(const CertificateAggregate& aggregate) const;
+    int domainId(const QString& domain);
+    // in the background from the fetcher thread, which drives every socket
+    void writeCheckpoint(bool inBackground = false);
+    void feedResolver();
+    void wakeResolver();
     void checkNonInUseSystemRootCAs();
-    QList<QSslCertificate> _systemCerts;
     QList<Certificate> _notInUseSystemRootCAList;
-    QHash<QString, Certificate> resultHash;
-    QList<Certificate> resultList;
+    QMutex m_resultMutex;
+    QHash<QByteArray, CertificateAggregate> resultHash; // keyed by Certificate::digest
+    QSet<QByteArray> m_dirty; // changed since the last publish
+    QHash<QString, int> m_domainIds;
+    QStringList m_domainNames;
+    QElapsedTimer m_lastPublish;
+    int m_hostsDone = 0;
+    QHash<QString, QList<int>> m_hostIndex; // every position in m_hostnames
+    QBitArray m_hostsCompleted;
+    QStringList m_incoming; // appended during the scan, not yet handed to the resolver
+    HostResolver* m_resolver = nullptr; // of the running scan, under m_resultMutex
+    ScanScheduler* m_scheduler = nullptr; // of the running scan, under m_resultMutex
+    QFuture<void> m_scan;
+    std::atomic<bool> m_hostnamesComplete = true;
+    QElapsedTimer m_lastCheckpoint;
+    QFuture<void> m_checkpointSave;
+    std::atomic<bool> m_checkpointSaving = false;
+    bool m_resume = false;
+    ScanMetrics m_metrics;
     CACertificateListModel *m_issuersCounted = nullptr;
     CACertificateListModel *_notInUseSystemRootCAs = nullptr;
     QString m_statusText;
     int m_progress;
     int m_privateProgress;
     std::atomic<bool> m_stop = false;
+    std::atomic<int> m_concurrency = 10;
+    std::atomic<int> m_perGroupConcurrency = 4;
+    std::atomic<bool> m_adaptiveConcurrency = true;
+    int m_currentConcurrency = 0;
+    std::atomic<bool> m_handshakeOnly = false;
+    std::atomic<int> m_cacheTtlHours = 0;
 };
 
 Q_DECLARE_METATYPE(QIntPair)
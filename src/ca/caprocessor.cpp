@@ -14,6 +14,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #include "caprocessor.h"
+#include "truststore.h"
+#include "certificateinterntable.h"
 
 #include <iostream>
 #include <QAssociativeIterable>
@@ -23,9 +25,8 @@
 #include <QSslCertificateExtension>
 #include <QString>
 #include <QSslConfiguration>
-#include <QNetworkReply>
-#include <QNetworkAccessManager>
 #include <QEventLoop>
+#include <QCryptographicHash>
 
 CAProcessor::CAProcessor(QObject *parent)
     : QObject{parent}
@@ -56,49 +57,51 @@ bool CAProcessor::isCA(const QSslCertificate& cert)
     return false;
 }
 
-void CAProcessor::ignoreSslErrors(QNetworkReply* reply)
-{
-    if(reply)
-        reply->ignoreSslErrors();
-}
-QList<Certificate> CAProcessor::getCertificate(const QString& domain)
+QList<Certificate> CAProcessor::getCertificate(const QString& domain, CertificateFetcher::Mode mode, HostMetrics* out_metrics)
 {
     QList<Certificate> resultList;
-    QNetworkAccessManager nam;
-    QNetworkRequest request;
-    request.setUrl("https://" + domain);
-    request.setTransferTimeout(3500);
-    request.setRawHeader("User-Agent","Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/106.0.0.0 Safari/537.36 Edg/106.0.1370.52");
-    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::UserVerifiedRedirectPolicy);
+    bool done = false;
+    CertificateFetcher fetcher;
+    fetcher.setMode(mode);
+    QEventLoop loop;
+
+    if(out_metrics)
+        connect(&fetcher, &CertificateFetcher::measured, &loop, [out_metrics](const HostMetrics& metrics) { *out_metrics = metrics; });
+    connect(&fetcher, &CertificateFetcher::finished, &loop, [&](const QString&, const QList<Certificate>& certificates) {
+        resultList = certificates;
+        done = true;
+        loop.quit();
+    });
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &loop, &QEventLoop::quit);
 
-    QEventLoop loop;    
-    QNetworkReply* reply = nam.get(request);  
+    fetcher.fetch(domain);
+    if(!done)
+        loop.exec();
 
-    QTimer::singleShot(4000, &loop, &QEventLoop::quit); // backup timeout
-    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &loop, &QEventLoop::quit);
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    connect(&nam, &QNetworkAccessManager::sslErrors, &CAProcessor::ignoreSslErrors);
-    loop.exec();
-
-    if(reply && (reply->error() > QNetworkReply::NoError && reply->error() <= QNetworkReply::UnknownNetworkError) ) {
-        Certificate error;
-        QString errorString = reply->errorString();
-        error.subject = domain + ": " + errorString ;
-        error.domains.push_back(domain);
-        error.errors.push_back(errorString);
-        reply->deleteLater();
-        return {error};
-    }
+    return resultList;
+}
 
-    QList<QSslCertificate> systemCerts = QSslConfiguration::systemCaCertificates();
-    // add last root cert if server did not sent it
-    QList<QSslCertificate> peerCertChain;
-    if(reply)
-        peerCertChain = reply->sslConfiguration().peerCertificateChain();
+Certificate CAProcessor::errorCertificate(const QString &domain, const QString &errorString)
+{
+    Certificate error;
+    error.subject = domain + ": " + errorString ;
+    error.digest = QCryptographicHash::hash(error.subject.toUtf8(), QCryptographicHash::Sha256);
+    error.domains.push_back(domain);
+    error.errors.push_back(errorString);
+    return error;
+}
+
+QList<Certificate> CAProcessor::certificatesFromChain(const QString &domain, QList<QSslCertificate> peerCertChain)
+{
+    if(peerCertChain.isEmpty())
+        return {errorCertificate(domain, "No certificate chain received")};
 
-    auto it = std::find_if(systemCerts.begin(), systemCerts.end(), [&peerCertChain](const QSslCertificate& sys){ return peerCertChain.last().issuerDisplayName() == sys.subjectDisplayName(); });
-    if(it != systemCerts.end())
-        peerCertChain.push_back(*it);
+    QList<Certificate> resultList;
+    const TrustStore& systemStore = TrustStore::system();
+    // add last root cert if server did not sent it
+    QSslCertificate root = systemStore.findIssuer(peerCertChain.last());
+    if(!root.isNull() && root != peerCertChain.last())
+        peerCertChain.push_back(root);
 
     for(auto it = peerCertChain.begin(); it != peerCertChain.end(); ++it) {
         QSslCertificate cert = *it;
@@ -106,19 +109,14 @@ QList<Certificate> CAProcessor::getCertificate(const QString& domain)
         if(cert.isNull())
             continue;
 
-        Certificate result = parseQSslCertificateToCertificate(cert);
+        // copy of the interned certificate, shares all its data
+        Certificate result = *CertificateInternTable::instance().intern(cert);
 
         result.domains.push_back(domain);
 
-        if(std::find(systemCerts.begin(), systemCerts.end(), cert) != systemCerts.end())
-            result.isSystemTrustedRootCA = true;
-
         resultList.push_back(result);
     }
 
-
-    reply->deleteLater();
-
     return resultList;
 }
 
@@ -254,6 +252,7 @@ Certificate CAProcessor::parseQSslCertificateToCertificate(const QSslCertificate
 
 
     result._actualCert = cert;
+    result.digest = TrustStore::digestOf(cert);
 
     result.isCA = isCA(cert);
 
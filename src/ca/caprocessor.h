@@ -17,29 +17,29 @@
 #pragma once
 
 #include "certificate.h"
+#include "certificatefetcher.h"
 
 #include <QSslCertificate>
 #include <QVector>
 #include <QObject>
 
-class QNetworkReply;
-
 class CAProcessor : public QObject
 {
     Q_OBJECT
 public:
     explicit CAProcessor(QObject *parent = nullptr);
 
-    static QList<Certificate> getCertificate(const QString& domain);
+    // Synchronous wrapper around CertificateFetcher, blocks until the chain is in.
+    // Timings and outcome of the fetch go to out_metrics when given.
+    static QList<Certificate> getCertificate(const QString& domain, CertificateFetcher::Mode mode = CertificateFetcher::HttpGet, HostMetrics* out_metrics = nullptr);
+    static QList<Certificate> certificatesFromChain(const QString& domain, QList<QSslCertificate> peerCertChain);
+    static Certificate errorCertificate(const QString& domain, const QString& errorString);
     static bool isCA(const QSslCertificate& cert);
     
     static Certificate parseQSslCertificateToCertificate(const QSslCertificate& cert);
     
 signals:
 
-private slots:
-    static void ignoreSslErrors(QNetworkReply* reply);
-
 private:
     static void extractSubject(const QSslCertificate& cert, Certificate& out_issuer);
     static void extractCertificate(const QSslCertificate& cert, Certificate& out_issuer);
@@ -16,7 +16,7 @@
 
 #pragma once
 
-#include <sstream>
+#include <ostream>
 #include <QObject>
 #include <QDateTime>
 #include <QString>
@@ -50,37 +50,37 @@ public:
 
 
     QString toQString() const {
-        return QString::fromStdString(toString());
-    }
-
-    std::string toString() const {
-        std::string result;
+        QString result;
         if(!country.isEmpty())
-            result.append("C  : " + country.toStdString() + "\n");
+            result.append(QStringLiteral("C  : ") + country + '\n');
         if(!state.isEmpty())
-            result.append("ST : " + state.toStdString() + "\n");
+            result.append(QStringLiteral("ST : ") + state + '\n');
         if(!locality.isEmpty())
-            result.append("L  : " + locality.toStdString() + "\n");
+            result.append(QStringLiteral("L  : ") + locality + '\n');
         if(!organization.isEmpty())
-            result.append("O  : " + organization.toStdString() + "\n");
+            result.append(QStringLiteral("O  : ") + organization + '\n');
         if(!organizationalUnit.isEmpty())
-            result.append("OU : " + organizationalUnit.toStdString() + "\n");
+            result.append(QStringLiteral("OU : ") + organizationalUnit + '\n');
         if(!commonName.isEmpty())
-            result.append("CN : " + commonName.toStdString() + "\n");
+            result.append(QStringLiteral("CN : ") + commonName + '\n');
         if(!distinguishedName.isEmpty())
-            result.append("DN : " + distinguishedName.toStdString() + "\n");
+            result.append(QStringLiteral("DN : ") + distinguishedName + '\n');
         if(!email.isEmpty())
-            result.append("E  : " + email.toStdString() + "\n");
+            result.append(QStringLiteral("E  : ") + email + '\n');
         if(!serial.isEmpty())
-            result.append("SN : " + serial.toStdString() + "\n");
+            result.append(QStringLiteral("SN : ") + serial + '\n');
 
-        if(result.empty())
-            result.append("Empty Subject\n");
+        if(result.isEmpty())
+            result.append(QStringLiteral("Empty Subject\n"));
 
 
         return result;
     }
 
+    std::string toString() const {
+        return toQString().toStdString();
+    }
+
     friend std::ostream& operator<<(std::ostream& os, const SubjectInfo& subjectInfo) {
         os << subjectInfo.toString();
         return os;
@@ -149,6 +149,7 @@ public:
     QStringList domains; // domain that was in user provided history
     QStringList subjectAlternativeNames; // all domains that cert has
     QStringList errors;
+    QByteArray digest; // SHA-256 of the DER encoding, of the subject for errors
     QSslCertificate _actualCert;
 
     bool operator==(const Certificate& other) const {
@@ -166,56 +167,69 @@ public:
             return subject.localeAwareCompare(other.subject);
     }
 
-    QString toQString() const {
-        return QString::fromStdString(toString());
+    // leaf, intermediate, root (system trusted), untrusted (self signed CA) or error
+    QString kindString() const {
+        if(!errors.isEmpty())
+            return QStringLiteral("error");
+        if(isSystemTrustedRootCA)
+            return QStringLiteral("root");
+        if(isCA)
+            return isSelfSigned ? QStringLiteral("untrusted") : QStringLiteral("intermediate");
+        return QStringLiteral("leaf");
     }
 
-    std::string toString() const {
-        std::stringstream ss;
-        ss << "Count: " << count << "; \n"
-           << "Subject: " << subject.toStdString() << "; \n";
-        ss << subjectInfo.toString() << "\n\n";
+    // Built directly as a QString, the list model shows this text for every row.
+    QString toQString() const {
+        QString result;
+        result.reserve(1024);
+        result.append(QStringLiteral("Count: ") + QString::number(count) + QStringLiteral("; \n")
+                      + QStringLiteral("Subject: ") + subject + QStringLiteral("; \n"));
+        result.append(subjectInfo.toQString() + QStringLiteral("\n\n"));
 
-        ss << "Valid From: " << validFromDate.toString().toStdString() << "\n";
-        ss << "Valid Until:" << validUntilDate.toString().toStdString() << "\n";
+        result.append(QStringLiteral("Valid From: ") + validFromDate.toString() + '\n');
+        result.append(QStringLiteral("Valid Until:") + validUntilDate.toString() + '\n');
 
-        ss << "Issuer: " << issuer.toStdString() << "; \n";
-        ss << issuerInfo.toString() << "\n\n";
+        result.append(QStringLiteral("Issuer: ") + issuer + QStringLiteral("; \n"));
+        result.append(issuerInfo.toQString() + QStringLiteral("\n\n"));
 
-        ss << "CA: " << (isCA ? "true" : "false") <<  "\n";
+        result.append(QStringLiteral("CA: ") + (isCA ? QStringLiteral("true") : QStringLiteral("false")) + '\n');
 
-        ss << "Self Signed: " << (isSelfSigned ? "true" : "false") <<  "\n";
+        result.append(QStringLiteral("Self Signed: ") + (isSelfSigned ? QStringLiteral("true") : QStringLiteral("false")) + '\n');
 
-        ss << "Trusted Root CA:" << (isSystemTrustedRootCA ? "true" : "false") <<  "\n";
+        result.append(QStringLiteral("Trusted Root CA:") + (isSystemTrustedRootCA ? QStringLiteral("true") : QStringLiteral("false")) + '\n');
 
         if(!domains.isEmpty()) {
-            ss << "User Domains: ";
+            result.append(QStringLiteral("User Domains: "));
 
             for (const auto& domain : domains) {
-                ss << domain.toStdString() << " ";
+                result.append(domain + ' ');
             }
-            ss << "; \n";
+            result.append(QStringLiteral("; \n"));
         }
 
         if(!subjectAlternativeNames.isEmpty()) {
-        ss << "subjectAltNames: ";
+        result.append(QStringLiteral("subjectAltNames: "));
 
             for (const auto& san : subjectAlternativeNames) {
-                ss << san.toStdString() << " ";
+                result.append(san + ' ');
             }
-            ss << "; \n";
+            result.append(QStringLiteral("; \n"));
         }
 
         if(!errors.isEmpty()) {
-            ss << "Errors:         ";
+            result.append(QStringLiteral("Errors:         "));
 
             for (const auto& err : errors) {
-                ss << err.toStdString() << " ";
+                result.append(err + ' ');
             }
-            ss << "; \n";
+            result.append(QStringLiteral("; \n"));
         }
 
-        return ss.str();
+        return result;
+    }
+
+    std::string toString() const {
+        return toQString().toStdString();
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Certificate& issuer) {
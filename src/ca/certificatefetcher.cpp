@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "certificatefetcher.h"
+#include "caprocessor.h"
+
+#include <QMetaEnum>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSslConfiguration>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUrl>
+
+CertificateFetcher::CertificateFetcher(QObject *parent)
+    : QObject{parent}
+{
+
+}
+
+CertificateFetcher::Mode CertificateFetcher::mode() const
+{
+    return m_mode;
+}
+
+void CertificateFetcher::setMode(Mode newMode)
+{
+    m_mode = newMode;
+}
+
+int CertificateFetcher::timeout() const
+{
+    return m_timeout;
+}
+
+void CertificateFetcher::setTimeout(int newTimeout)
+{
+    m_timeout = newTimeout;
+}
+
+int CertificateFetcher::pendingCount() const
+{
+    return m_pending.size();
+}
+
+void CertificateFetcher::fetch(const QString &domain, const QStringList &addresses)
+{
+    if(m_mode == HandshakeOnly)
+        fetchHandshake(domain, addresses);
+    else
+        fetchHttp(domain);
+}
+
+void CertificateFetcher::fetchHttp(const QString &domain)
+{
+    // created lazily so the manager lives in the thread the fetcher was moved to
+    if(!m_manager) {
+        m_manager = new QNetworkAccessManager(this);
+        connect(m_manager, &QNetworkAccessManager::sslErrors, this, [](QNetworkReply* reply) {
+            if(reply)
+                reply->ignoreSslErrors();
+        });
+    }
+
+    QNetworkRequest request;
+    request.setUrl("https://" + domain);
+    request.setTransferTimeout(m_timeout - 500);
+    request.setRawHeader("User-Agent","Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/106.0.0.0 Safari/537.36 Edg/106.0.1370.52");
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::UserVerifiedRedirectPolicy);
+
+    QNetworkReply* reply = m_manager->get(request);
+    startRequest(reply, domain);
+
+    // QNAM does not report DNS and connect separately, this covers all three
+    connect(reply, &QNetworkReply::encrypted, this, [this, reply]() { markPhase(reply, &HostMetrics::handshakeMs); });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { complete(reply, false); });
+    // the chain is known by the time a redirect comes in, no need to follow it
+    connect(reply, &QNetworkReply::redirected, this, [this, reply]() { complete(reply, false); });
+    QTimer::singleShot(m_timeout, reply, [this, reply]() { complete(reply, true); }); // backup timeout
+}
+
+void CertificateFetcher::fetchHandshake(const QString &domain, const QStringList &addresses)
+{
+    // domain may carry a port, e.g. example.org:8443
+    const QUrl url("https://" + domain);
+
+    QSslSocket* socket = new QSslSocket(this);
+    socket->setPeerVerifyMode(QSslSocket::VerifyNone);
+    startRequest(socket, domain);
+    m_pending[socket].addresses = addresses;
+
+    // DNS was already timed by whoever resolved the address
+    if(addresses.isEmpty())
+        connect(socket, &QSslSocket::hostFound, this, [this, socket]() { markPhase(socket, &HostMetrics::dnsMs); });
+    connect(socket, &QSslSocket::connected, this, [this, socket]() {
+        auto it = m_pending.find(socket);
+        if(it != m_pending.end())
+            it->connected = true;
+        markPhase(socket, &HostMetrics::connectMs);
+    });
+    connect(socket, &QSslSocket::encrypted, this, [this, socket]() {
+        markPhase(socket, &HostMetrics::handshakeMs);
+        complete(socket, false);
+    });
+    connect(socket, &QSslSocket::errorOccurred, this, [this, socket]() {
+        if(!connectNextAddress(socket))
+            complete(socket, false);
+    });
+    QTimer::singleShot(m_timeout, socket, [this, socket]() { complete(socket, true); });
+
+    if(addresses.isEmpty())
+        socket->connectToHostEncrypted(url.host(), url.port(443));
+    else
+        connectNextAddress(socket);
+}
+
+bool CertificateFetcher::connectNextAddress(QSslSocket *socket)
+{
+    // only a failed connect moves on, a TLS error comes from the right server
+    auto it = m_pending.find(socket);
+    if(it == m_pending.end() || it->connected || it->nextAddress >= it->addresses.size())
+        return false;
+
+    const QString address = it->addresses.at(it->nextAddress++);
+    const QUrl url("https://" + it->metrics.domain);
+    // not from inside the error signal of the same socket
+    QTimer::singleShot(0, socket, [this, socket, address, url]() {
+        if(!m_pending.contains(socket))
+            return;
+        socket->abort();
+        socket->connectToHostEncrypted(address, url.port(443), url.host());
+    });
+    return true;
+}
+
+void CertificateFetcher::startRequest(QObject *request, const QString &domain)
+{
+    Request& r = m_pending[request];
+    r.metrics.domain = domain;
+    r.started.start();
+}
+
+void CertificateFetcher::markPhase(QObject *request, qint64 HostMetrics::*phase)
+{
+    auto it = m_pending.find(request);
+    if(it == m_pending.end())
+        return;
+
+    // phases are stored as durations, not as time since the start
+    const qint64 now = it->started.elapsed();
+    it->metrics.*phase = now - it->lastPhaseMs;
+    it->lastPhaseMs = now;
+}
+
+bool CertificateFetcher::takePending(QObject *request, Request &out_request)
+{
+    auto it = m_pending.find(request);
+    if(it == m_pending.end())
+        return false;
+
+    out_request = it.value();
+    m_pending.erase(it);
+    return true;
+}
+
+void CertificateFetcher::report(Request &request, const QList<Certificate> &result)
+{
+    request.metrics.totalMs = request.started.elapsed();
+    emit measured(request.metrics);
+    emit finished(request.metrics.domain, result);
+}
+
+void CertificateFetcher::complete(QSslSocket *socket, bool timedOut)
+{
+    Request request;
+    if(!takePending(socket, request))
+        return;
+
+    const QString& domain = request.metrics.domain;
+    HostMetrics& metrics = request.metrics;
+    QList<Certificate> result;
+    const QList<QSslCertificate> peerCertChain = socket->peerCertificateChain();
+    if(!peerCertChain.isEmpty()) {
+        result = CAProcessor::certificatesFromChain(domain, peerCertChain);
+    } else if(timedOut) {
+        metrics.outcome = HostMetrics::Timeout;
+        result = {CAProcessor::errorCertificate(domain, "Operation timed out")};
+    } else {
+        const QAbstractSocket::SocketError error = socket->error();
+        if(error == QAbstractSocket::SslHandshakeFailedError || error == QAbstractSocket::SslInternalError)
+            metrics.outcome = HostMetrics::TlsError;
+        else
+            metrics.outcome = HostMetrics::NetworkError;
+        metrics.errorName = QMetaEnum::fromType<QAbstractSocket::SocketError>().valueToKey(error);
+        result = {CAProcessor::errorCertificate(domain, socket->errorString())};
+    }
+
+    socket->abort();
+    socket->deleteLater();
+
+    report(request, result);
+}
+
+void CertificateFetcher::complete(QNetworkReply *reply, bool timedOut)
+{
+    Request request;
+    if(!takePending(reply, request))
+        return;
+
+    const QString& domain = request.metrics.domain;
+    HostMetrics& metrics = request.metrics;
+    QList<Certificate> result;
+    const QList<QSslCertificate> peerCertChain = reply->sslConfiguration().peerCertificateChain();
+    if(!timedOut && reply->error() > QNetworkReply::NoError && reply->error() <= QNetworkReply::UnknownNetworkError) {
+        metrics.outcome = reply->error() == QNetworkReply::SslHandshakeFailedError ? HostMetrics::TlsError : HostMetrics::NetworkError;
+        metrics.errorName = QMetaEnum::fromType<QNetworkReply::NetworkError>().valueToKey(reply->error());
+        result = {CAProcessor::errorCertificate(domain, reply->errorString())};
+    } else if(timedOut && peerCertChain.isEmpty()) {
+        metrics.outcome = HostMetrics::Timeout;
+        result = {CAProcessor::errorCertificate(domain, "Operation timed out")};
+    } else {
+        if(peerCertChain.isEmpty()) {
+            metrics.outcome = HostMetrics::NetworkError;
+            metrics.errorName = QStringLiteral("NoCertificateChain");
+        }
+        result = CAProcessor::certificatesFromChain(domain, peerCertChain);
+    }
+
+    if(reply->isRunning())
+        reply->abort();
+    reply->deleteLater();
+
+    report(request, result);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "certificate.h"
+#include "scanmetrics.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QSslSocket;
+
+/* Non-blocking certificate chain fetcher. One instance drives all
+ * in-flight requests from the event loop of the thread it lives in,
+ * using a single QNetworkAccessManager. Call fetch() (queued, when the
+ * fetcher lives in another thread) and wait for finished().
+ *
+ * In HandshakeOnly mode no HTTP request is sent, the TLS handshake is
+ * done on a plain QSslSocket and the connection is closed as soon as the
+ * peer chain is known.
+ *
+ * With addresses given (already resolved) the handshake goes straight
+ * to the first one, the domain is still sent as SNI. When the connect
+ * fails the next address is tried, within the same timeout. HTTP mode
+ * resolves through QNetworkAccessManager, which hits Qt's host lookup
+ * cache then.
+ *
+ * Every fetch also reports its timings and outcome with measured(),
+ * emitted just before finished().
+ */
+class CertificateFetcher : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        HttpGet,
+        HandshakeOnly
+    };
+    Q_ENUM(Mode)
+
+    explicit CertificateFetcher(QObject *parent = nullptr);
+
+    Mode mode() const;
+    void setMode(Mode newMode);
+
+    int timeout() const;
+    void setTimeout(int newTimeout);
+
+    int pendingCount() const;
+
+public slots:
+    void fetch(const QString& domain, const QStringList& addresses = QStringList());
+
+signals:
+    void measured(const HostMetrics& metrics);
+    void finished(const QString& domain, const QList<Certificate>& certificates);
+
+private:
+    struct Request {
+        QElapsedTimer started;
+        qint64 lastPhaseMs = 0;
+        HostMetrics metrics;
+        // handshake mode, addresses left to try while not connected
+        QStringList addresses;
+        int nextAddress = 0;
+        bool connected = false;
+    };
+
+    void fetchHttp(const QString& domain);
+    void fetchHandshake(const QString& domain, const QStringList& addresses);
+    bool connectNextAddress(QSslSocket* socket);
+    void startRequest(QObject* request, const QString& domain);
+    void markPhase(QObject* request, qint64 HostMetrics::*phase);
+    bool takePending(QObject* request, Request& out_request);
+    void complete(QNetworkReply* reply, bool timedOut);
+    void complete(QSslSocket* socket, bool timedOut);
+    void report(Request& request, const QList<Certificate>& result);
+    QNetworkAccessManager* m_manager = nullptr;
+    QHash<QObject*, Request> m_pending;
+    Mode m_mode = HttpGet;
+    int m_timeout = 4000;
+};
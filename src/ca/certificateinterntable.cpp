@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "certificateinterntable.h"
+#include "caprocessor.h"
+#include "truststore.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+
+CertificateInternTable &CertificateInternTable::instance()
+{
+    static CertificateInternTable table;
+    return table;
+}
+
+QSharedPointer<const Certificate> CertificateInternTable::intern(const QSslCertificate &cert)
+{
+    const QByteArray digest = TrustStore::digestOf(cert);
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_table.constFind(digest);
+        if(it != m_table.constEnd())
+            return it.value();
+    }
+
+    // parse outside of the lock, another thread might beat us to it
+    QSharedPointer<Certificate> parsed = QSharedPointer<Certificate>::create(CAProcessor::parseQSslCertificateToCertificate(cert));
+    parsed->isSystemTrustedRootCA = TrustStore::system().containsDigest(digest);
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_table.constFind(digest);
+    if(it != m_table.constEnd())
+        return it.value();
+    m_table.insert(digest, parsed);
+    return parsed;
+}
+
+QSharedPointer<const Certificate> CertificateInternTable::find(const QByteArray &digest) const
+{
+    QReadLocker locker(&m_lock);
+    return m_table.value(digest);
+}
+
+int CertificateInternTable::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_table.size();
+}
+
+void CertificateInternTable::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_table.clear();
+}
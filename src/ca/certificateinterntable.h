@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "certificate.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QSslCertificate>
+
+/* Parsed certificates keyed by the SHA-256 digest of their DER encoding.
+ * The same intermediates and roots come back from thousands of hosts,
+ * they are parsed once and every copy handed out shares the strings and
+ * the QSslCertificate of the interned one. Thread safe.
+ */
+class CertificateInternTable
+{
+public:
+    static CertificateInternTable& instance();
+
+    // Interned certificates have no domains and a count of 0, callers
+    // copy the entry and add their own attribution.
+    QSharedPointer<const Certificate> intern(const QSslCertificate& cert);
+    QSharedPointer<const Certificate> find(const QByteArray& digest) const;
+
+    int size() const;
+    void clear();
+
+private:
+    mutable QReadWriteLock m_lock;
+    QHash<QByteArray, QSharedPointer<const Certificate>> m_table;
+};
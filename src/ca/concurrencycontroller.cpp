@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "concurrencycontroller.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+
+namespace {
+const int minWindowHosts = 20;
+const qint64 minWindowMs = 500;
+const int additiveStep = 2;
+const double decreaseFactor = 0.7;
+const double throughputTolerance = 0.9;
+const double minErrorRate = 0.05; // noise, dead hosts in the history
+}
+
+ConcurrencyController::ConcurrencyController(int initial, int minimum, int maximum)
+    : m_minimum(std::max(1, minimum)), m_maximum(std::max(m_minimum, maximum))
+{
+    m_limit = std::clamp(initial, m_minimum, m_maximum);
+}
+
+int ConcurrencyController::record(const HostMetrics &metrics)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_window.isValid())
+        m_window.start();
+
+    ++m_completed;
+    // TLS errors are the server's doing, not a sign of overload
+    if(metrics.outcome == HostMetrics::Timeout || metrics.outcome == HostMetrics::NetworkError)
+        ++m_failed;
+
+    const qint64 elapsed = m_window.elapsed();
+    if(m_completed >= std::max(m_limit, minWindowHosts) && elapsed >= minWindowMs)
+        endWindow(elapsed);
+
+    return m_limit;
+}
+
+int ConcurrencyController::limit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+void ConcurrencyController::endWindow(qint64 elapsedMs)
+{
+    const double throughput = m_completed * 1000.0 / elapsedMs;
+    const double errorRate = double(m_failed) / m_completed;
+    if(m_baselineErrorRate < 0)
+        m_baselineErrorRate = errorRate;
+
+    if(errorRate > std::max(minErrorRate, m_baselineErrorRate * 2)) {
+        m_slowStart = false;
+        m_limit = std::max(m_minimum, int(m_limit * decreaseFactor));
+    } else {
+        m_baselineErrorRate = 0.8 * m_baselineErrorRate + 0.2 * errorRate;
+        if(m_lastThroughput > 0 && throughput < m_lastThroughput * throughputTolerance) {
+            // more in flight did not pay off
+            m_slowStart = false;
+            m_limit = std::max(m_minimum, m_limit - additiveStep);
+        } else if(m_slowStart) {
+            m_limit = std::min(m_maximum, m_limit * 2);
+        } else {
+            m_limit = std::min(m_maximum, m_limit + additiveStep);
+        }
+    }
+
+    m_lastThroughput = throughput;
+    m_completed = 0;
+    m_failed = 0;
+    m_window.restart();
+}
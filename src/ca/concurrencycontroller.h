@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "scanmetrics.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+/* AIMD controller for the number of hosts in flight. Results are judged
+ * per window of about one concurrency worth of finished hosts:
+ *  - timeouts and connection errors well above what the scan normally
+ *    sees: multiplicative decrease,
+ *  - throughput dropped compared to the previous window: one step back,
+ *  - otherwise: double while in slow start, then one step up.
+ * Thread safe, fed from the thread that finishes the hosts.
+ */
+class ConcurrencyController
+{
+public:
+    explicit ConcurrencyController(int initial = 10, int minimum = 1, int maximum = 256);
+
+    // Returns the limit to use from now on.
+    int record(const HostMetrics& metrics);
+    int limit() const;
+
+private:
+    void endWindow(qint64 elapsedMs);
+
+    mutable QMutex m_mutex;
+    int m_limit;
+    int m_minimum;
+    int m_maximum;
+    bool m_slowStart = true;
+    QElapsedTimer m_window;
+    int m_completed = 0;
+    int m_failed = 0;
+    double m_lastThroughput = 0;
+    double m_baselineErrorRate = -1; // learned from the healthy windows only
+};
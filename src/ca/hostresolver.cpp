@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hostresolver.h"
+
+#include <algorithm>
+#include <QHostInfo>
+#include <QUrl>
+
+HostResolver::HostResolver(QObject *parent)
+    : QObject{parent}
+{
+
+}
+
+int HostResolver::maxPending() const
+{
+    return m_maxPending;
+}
+
+void HostResolver::setMaxPending(int newMaxPending)
+{
+    m_maxPending = std::max(1, newMaxPending);
+}
+
+void HostResolver::setGate(const std::function<bool()> &gate)
+{
+    m_gate = gate;
+}
+
+void HostResolver::enqueue(const QStringList &hosts)
+{
+    for(const QString& host : hosts)
+        m_queue.enqueue(host);
+}
+
+bool HostResolver::isIdle() const
+{
+    return m_queue.isEmpty() && m_pending == 0;
+}
+
+void HostResolver::openInput()
+{
+    m_inputOpen = true;
+}
+
+void HostResolver::closeInput()
+{
+    m_inputOpen = false;
+    pump();
+}
+
+void HostResolver::pump()
+{
+    while(!m_queue.isEmpty() && m_pending < m_maxPending && (!m_gate || m_gate()))
+        lookup(m_queue.dequeue());
+
+    if(isIdle() && !m_inputOpen)
+        emit drained();
+}
+
+void HostResolver::lookup(const QString &host)
+{
+    // host may carry a port, e.g. example.org:8443
+    const QString name = QUrl("https://" + host).host();
+
+    ++m_pending;
+    QElapsedTimer timer;
+    timer.start();
+    QHostInfo::lookupHost(name, this, [this, host, timer](const QHostInfo& info) {
+        --m_pending;
+        if(info.error() == QHostInfo::HostNotFound)
+            emit notFound(host, info.errorString(), timer.elapsed());
+        else
+            emit resolved(host, info.addresses(), timer.elapsed());
+        pump();
+    });
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <functional>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+
+/* DNS stage in front of the TLS fetches. Keeps up to maxPending QHostInfo
+ * lookups running (Qt runs them on its own lookup threads) and reports
+ * each host with its addresses, or as not found. Lookups only start
+ * while the gate says the next stage wants more work, so the resolver
+ * runs ahead of the scan but not through the whole list at once.
+ *
+ * Lives in one thread, call enqueue() and pump() from there.
+ */
+class HostResolver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HostResolver(QObject *parent = nullptr);
+
+    int maxPending() const;
+    void setMaxPending(int newMaxPending);
+
+    // Called before every lookup, false holds the resolver until the next pump().
+    void setGate(const std::function<bool()>& gate);
+
+    void enqueue(const QStringList& hosts);
+    bool isIdle() const;
+
+    // While the input is open more hosts may follow, drained() waits for
+    // closeInput(). Closed by default.
+    void openInput();
+
+public slots:
+    // Start as many lookups as the limits allow.
+    void pump();
+    void closeInput();
+
+signals:
+    // addresses is empty when the lookup failed for another reason than
+    // the name not existing, the fetch then resolves on its own.
+    void resolved(const QString& host, const QList<QHostAddress>& addresses, qint64 elapsedMs);
+    void notFound(const QString& host, const QString& errorString, qint64 elapsedMs);
+    // queue empty, no lookups running and the input closed
+    void drained();
+
+private:
+    void lookup(const QString& host);
+
+    QQueue<QString> m_queue;
+    std::function<bool()> m_gate;
+    int m_maxPending = 64;
+    int m_pending = 0;
+    bool m_inputOpen = false;
+};
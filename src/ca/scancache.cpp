@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scancache.h"
+#include "caprocessor.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSslCertificate>
+#include <QStandardPaths>
+
+namespace {
+const int digestSize = 32; // SHA-256
+}
+
+ScanCache::ScanCache(const QString &path)
+    : m_path(path)
+{
+    // connections are per thread, every cache gets its own
+    m_connectionName = QStringLiteral("scancache-") + QString::number(reinterpret_cast<quintptr>(this), 16);
+}
+
+ScanCache::~ScanCache()
+{
+    if(m_db.isValid()) {
+        m_db.close();
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+QString ScanCache::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/scancache.sqlite");
+}
+
+bool ScanCache::open()
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_db.setDatabaseName(m_path);
+    if(!m_db.open()) {
+        m_lastError = m_db.lastError().text();
+        return false;
+    }
+    return createTables();
+}
+
+QString ScanCache::lastError() const
+{
+    return m_lastError;
+}
+
+bool ScanCache::createTables()
+{
+    QSqlQuery query(m_db);
+    // digests is every SHA-256 of the chain in order, concatenated
+    if(!query.exec("CREATE TABLE IF NOT EXISTS hosts ("
+                   " host TEXT PRIMARY KEY,"
+                   " scanned_at INTEGER NOT NULL,"
+                   " digests BLOB NOT NULL)")
+        || !query.exec("CREATE TABLE IF NOT EXISTS certificates ("
+                       " digest BLOB PRIMARY KEY,"
+                       " der BLOB NOT NULL)")) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QHash<QString, QList<Certificate>> ScanCache::load(const QStringList &hostnames, qint64 maxAgeSecs)
+{
+    QHash<QString, QList<Certificate>> result;
+    if(!m_db.isOpen())
+        return result;
+
+    const QSet<QString> wanted(hostnames.cbegin(), hostnames.cend());
+    const qint64 oldest = QDateTime::currentSecsSinceEpoch() - maxAgeSecs;
+
+    // one pass over the fresh hosts, much cheaper than a query per host
+    QHash<QString, QByteArray> chains;
+    QSqlQuery hostQuery(m_db);
+    hostQuery.setForwardOnly(true);
+    hostQuery.prepare("SELECT host, digests FROM hosts WHERE scanned_at >= ?");
+    hostQuery.addBindValue(oldest);
+    if(!hostQuery.exec()) {
+        m_lastError = hostQuery.lastError().text();
+        return result;
+    }
+    while(hostQuery.next()) {
+        const QString host = hostQuery.value(0).toString();
+        if(wanted.contains(host))
+            chains.insert(host, hostQuery.value(1).toByteArray());
+    }
+
+    QHash<QByteArray, QSslCertificate> certs;
+    QSqlQuery certQuery(m_db);
+    certQuery.setForwardOnly(true);
+    certQuery.prepare("SELECT der FROM certificates WHERE digest = ?");
+
+    for(auto it = chains.constBegin(); it != chains.constEnd(); ++it) {
+        const QByteArray& digests = it.value();
+        QList<QSslCertificate> chain;
+        for(int i = 0; i + digestSize <= digests.size(); i += digestSize) {
+            const QByteArray digest = digests.mid(i, digestSize);
+            auto found = certs.constFind(digest);
+            if(found == certs.constEnd()) {
+                QSslCertificate cert;
+                certQuery.addBindValue(digest);
+                if(certQuery.exec() && certQuery.next())
+                    cert = QSslCertificate(certQuery.value(0).toByteArray(), QSsl::Der);
+                certQuery.finish();
+                found = certs.insert(digest, cert);
+            }
+            if(found.value().isNull()) {
+                chain.clear();
+                break;
+            }
+            chain.push_back(found.value());
+        }
+
+        // incomplete entries are fetched again
+        if(!chain.isEmpty())
+            result.insert(it.key(), CAProcessor::certificatesFromChain(it.key(), chain));
+    }
+
+    return result;
+}
+
+void ScanCache::store(const QString &hostname, const QList<Certificate> &certificates)
+{
+    if(certificates.isEmpty())
+        return;
+    for(const Certificate& c : certificates) {
+        if(!c.errors.isEmpty() || c._actualCert.isNull())
+            return;
+    }
+
+    QMutexLocker locker(&m_pendingMutex);
+    m_pending.push_back({hostname, certificates});
+}
+
+bool ScanCache::commit()
+{
+    QList<QPair<QString, QList<Certificate>>> pending;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        pending.swap(m_pending);
+    }
+    if(pending.isEmpty() || !m_db.isOpen())
+        return m_db.isOpen();
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    QSet<QByteArray> written;
+
+    // one transaction for the whole batch, not one fsync per host
+    m_db.transaction();
+    QSqlQuery hostQuery(m_db);
+    hostQuery.prepare("INSERT OR REPLACE INTO hosts (host, scanned_at, digests) VALUES (?, ?, ?)");
+    QSqlQuery certQuery(m_db);
+    certQuery.prepare("INSERT OR IGNORE INTO certificates (digest, der) VALUES (?, ?)");
+
+    bool ok = true;
+    for(const auto& entry : qAsConst(pending)) {
+        QByteArray digests;
+        digests.reserve(entry.second.size() * digestSize);
+        for(const Certificate& c : entry.second) {
+            digests.append(c.digest);
+            if(written.contains(c.digest))
+                continue;
+            written.insert(c.digest);
+            certQuery.addBindValue(c.digest);
+            certQuery.addBindValue(c._actualCert.toDer());
+            ok = ok && certQuery.exec();
+        }
+        hostQuery.addBindValue(entry.first);
+        hostQuery.addBindValue(now);
+        hostQuery.addBindValue(digests);
+        ok = ok && hostQuery.exec();
+        if(!ok)
+            break;
+    }
+
+    if(!ok) {
+        m_lastError = hostQuery.lastError().isValid() ? hostQuery.lastError().text() : certQuery.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    return m_db.commit();
+}
+
+bool ScanCache::prune(qint64 maxAgeSecs)
+{
+    if(!m_db.isOpen())
+        return false;
+
+    m_db.transaction();
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM hosts WHERE scanned_at < ?");
+    query.addBindValue(QDateTime::currentSecsSinceEpoch() - maxAgeSecs);
+    if(!query.exec()) {
+        m_lastError = query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    // the chains are blobs, so the digests still in use are collected here
+    // instead of matching them in SQL
+    QSet<QByteArray> used;
+    query.setForwardOnly(true);
+    if(!query.exec("SELECT digests FROM hosts")) {
+        m_lastError = query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    while(query.next()) {
+        const QByteArray digests = query.value(0).toByteArray();
+        for(int i = 0; i + digestSize <= digests.size(); i += digestSize)
+            used.insert(digests.mid(i, digestSize));
+    }
+
+    QList<QByteArray> orphans;
+    if(!query.exec("SELECT digest FROM certificates")) {
+        m_lastError = query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    while(query.next()) {
+        const QByteArray digest = query.value(0).toByteArray();
+        if(!used.contains(digest))
+            orphans.push_back(digest);
+    }
+    query.finish();
+
+    QSqlQuery deleteQuery(m_db);
+    deleteQuery.prepare("DELETE FROM certificates WHERE digest = ?");
+    for(const QByteArray& digest : qAsConst(orphans)) {
+        deleteQuery.addBindValue(digest);
+        if(!deleteQuery.exec()) {
+            m_lastError = deleteQuery.lastError().text();
+            m_db.rollback();
+            return false;
+        }
+    }
+    return m_db.commit();
+}
+
+bool ScanCache::clear()
+{
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        m_pending.clear();
+    }
+    if(!m_db.isOpen())
+        return false;
+
+    QSqlQuery query(m_db);
+    if(!query.exec("DELETE FROM hosts") || !query.exec("DELETE FROM certificates")) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "certificate.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+/* Scan results of earlier runs, kept in a small SQLite database in the
+ * application data folder. Maps a host to the digests of the chain it
+ * sent plus the time it was fetched, the DER of every certificate is
+ * stored once. Hosts that failed are never cached so they get retried.
+ *
+ * The database connection belongs to the thread that called open(),
+ * load() and commit() must run there. store() may be called from any
+ * thread, it only queues the result until the next commit().
+ */
+class ScanCache
+{
+public:
+    explicit ScanCache(const QString& path = defaultPath());
+    ~ScanCache();
+
+    static QString defaultPath();
+
+    bool open();
+    QString lastError() const;
+
+    // Certificates of every host in hostnames fetched less than maxAgeSecs ago.
+    QHash<QString, QList<Certificate>> load(const QStringList& hostnames, qint64 maxAgeSecs);
+    void store(const QString& hostname, const QList<Certificate>& certificates);
+    bool commit();
+    // Drops hosts fetched more than maxAgeSecs ago and the certificates no
+    // host refers to anymore.
+    bool prune(qint64 maxAgeSecs);
+    bool clear();
+
+private:
+    bool createTables();
+
+    QString m_path;
+    QString m_connectionName;
+    QSqlDatabase m_db;
+    QString m_lastError;
+    QMutex m_pendingMutex;
+    QList<QPair<QString, QList<Certificate>>> m_pending;
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scancheckpoint.h"
+#include "certificateinterntable.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSslCertificate>
+#include <QStandardPaths>
+
+namespace {
+const quint32 checkpointMagic = 0x43495343; // "CISC"
+const quint32 checkpointVersion = 1;
+}
+
+QString ScanCheckpoint::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/scan.checkpoint");
+}
+
+bool ScanCheckpoint::exists(const QString &path)
+{
+    return QFile::exists(path);
+}
+
+bool ScanCheckpoint::save(const State &state, const QString &path)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << checkpointMagic << checkpointVersion;
+    out << state.hostnames << state.completed << state.domainNames;
+
+    // certificates as DER, they are parsed (and interned) again on load
+    out << quint32(state.results.size());
+    for(auto it = state.results.constBegin(); it != state.results.constEnd(); ++it) {
+        const Certificate& c = *it.value().certificate;
+        out << it.key() << c._actualCert.toDer() << c.subject << c.errors
+            << qint32(it.value().count) << it.value().domainIds;
+    }
+
+    if(out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool ScanCheckpoint::load(State &state, const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != checkpointMagic || version != checkpointVersion)
+        return false;
+
+    State loaded;
+    in >> loaded.hostnames >> loaded.completed >> loaded.domainNames;
+    if(in.status() != QDataStream::Ok || loaded.completed.size() != loaded.hostnames.size())
+        return false;
+
+    quint32 resultCount = 0;
+    in >> resultCount;
+    for(quint32 i = 0; i < resultCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray digest, der;
+        QString subject;
+        QStringList errors;
+        qint32 count = 0;
+        CertificateAggregate aggregate;
+        in >> digest >> der >> subject >> errors >> count >> aggregate.domainIds;
+
+        for(int id : qAsConst(aggregate.domainIds)) {
+            if(id < 0 || id >= loaded.domainNames.size())
+                return false;
+        }
+
+        if(!der.isEmpty()) {
+            QSslCertificate cert(der, QSsl::Der);
+            if(cert.isNull())
+                return false;
+            aggregate.certificate = CertificateInternTable::instance().intern(cert);
+        } else {
+            QSharedPointer<Certificate> error = QSharedPointer<Certificate>::create();
+            error->subject = subject;
+            error->errors = errors;
+            error->digest = digest;
+            aggregate.certificate = error;
+        }
+        aggregate.count = count;
+        loaded.results.insert(digest, aggregate);
+    }
+
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    state = loaded;
+    return true;
+}
+
+void ScanCheckpoint::remove(const QString &path)
+{
+    QFile::remove(path);
+}
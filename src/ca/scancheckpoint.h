@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "caconcurrentgatherer.h"
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/* Progress of a running scan on disk, so a scan that was interrupted
+ * (app closed, stop pressed) can continue where it was instead of
+ * starting at the first host again. Written atomically with QSaveFile,
+ * a crash while saving leaves the previous checkpoint intact.
+ */
+class ScanCheckpoint
+{
+public:
+    struct State {
+        QStringList hostnames;
+        QBitArray completed; // one bit per entry in hostnames
+        QStringList domainNames; // CertificateAggregate::domainIds index this
+        QHash<QByteArray, CertificateAggregate> results;
+    };
+
+    static QString defaultPath();
+    static bool exists(const QString& path = defaultPath());
+    static bool save(const State& state, const QString& path = defaultPath());
+    static bool load(State& state, const QString& path = defaultPath());
+    static void remove(const QString& path = defaultPath());
+};
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scanmetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QMutexLocker>
+
+namespace {
+const int linearBuckets = 16;
+const int subBuckets = 8; // per power of two
+
+QVariantMap histogramSummary(const LatencyHistogram& histogram)
+{
+    return {
+        {"count", histogram.count()},
+        {"p50", histogram.percentile(0.50)},
+        {"p95", histogram.percentile(0.95)},
+        {"p99", histogram.percentile(0.99)},
+    };
+}
+
+QString histogramLine(const QString& name, const LatencyHistogram& histogram)
+{
+    if(histogram.count() == 0)
+        return name + QStringLiteral(": no samples\n");
+    return name + QStringLiteral(": p50 ") + QString::number(histogram.percentile(0.50))
+            + QStringLiteral(" ms, p95 ") + QString::number(histogram.percentile(0.95))
+            + QStringLiteral(" ms, p99 ") + QString::number(histogram.percentile(0.99))
+            + QStringLiteral(" ms (") + QString::number(histogram.count()) + QStringLiteral(" hosts)\n");
+}
+}
+
+int LatencyHistogram::bucketFor(qint64 ms)
+{
+    if(ms < linearBuckets)
+        return int(std::max<qint64>(0, ms));
+
+    int exponent = 0;
+    for(qint64 v = ms; v > 1; v >>= 1)
+        ++exponent;
+    const int sub = int(ms >> (exponent - 3)) & (subBuckets - 1);
+    return linearBuckets + (exponent - 4) * subBuckets + sub;
+}
+
+qint64 LatencyHistogram::upperBound(int bucket)
+{
+    if(bucket < linearBuckets)
+        return bucket;
+
+    const int exponent = (bucket - linearBuckets) / subBuckets + 4;
+    const int sub = (bucket - linearBuckets) % subBuckets;
+    return (qint64(subBuckets + sub + 1) << (exponent - 3)) - 1;
+}
+
+void LatencyHistogram::add(qint64 ms)
+{
+    if(ms < 0)
+        return;
+
+    const int bucket = bucketFor(ms);
+    if(bucket >= m_buckets.size())
+        m_buckets.resize(bucket + 1);
+    ++m_buckets[bucket];
+    ++m_count;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if(m_count == 0)
+        return -1;
+
+    const int rank = std::max(1, int(std::ceil(p * m_count)));
+    int seen = 0;
+    for(int i = 0; i < m_buckets.size(); ++i) {
+        seen += m_buckets.at(i);
+        if(seen >= rank)
+            return upperBound(i);
+    }
+    return upperBound(m_buckets.size() - 1);
+}
+
+int LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+void LatencyHistogram::clear()
+{
+    m_buckets.clear();
+    m_count = 0;
+}
+
+void ScanMetrics::record(const HostMetrics &metrics)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_hosts;
+    ++m_outcomes[metrics.outcomeString()];
+    m_dns.add(metrics.dnsMs);
+    m_connect.add(metrics.connectMs);
+    m_handshake.add(metrics.handshakeMs);
+    m_total.add(metrics.totalMs);
+}
+
+void ScanMetrics::recordDns(qint64 ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dns.add(ms);
+}
+
+void ScanMetrics::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hosts = 0;
+    m_outcomes.clear();
+    m_dns.clear();
+    m_connect.clear();
+    m_handshake.clear();
+    m_total.clear();
+}
+
+QVariantMap ScanMetrics::summary() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap outcomes;
+    for(auto it = m_outcomes.constBegin(); it != m_outcomes.constEnd(); ++it)
+        outcomes.insert(it.key(), it.value());
+
+    return {
+        {"hosts", m_hosts},
+        {"outcomes", outcomes},
+        {"dns", histogramSummary(m_dns)},
+        {"connect", histogramSummary(m_connect)},
+        {"handshake", histogramSummary(m_handshake)},
+        {"total", histogramSummary(m_total)},
+    };
+}
+
+QString ScanMetrics::summaryText() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString result;
+    result.append(QStringLiteral("Hosts fetched: ") + QString::number(m_hosts) + '\n');
+    for(auto it = m_outcomes.constBegin(); it != m_outcomes.constEnd(); ++it)
+        result.append(QStringLiteral("  ") + it.key() + QStringLiteral(": ") + QString::number(it.value()) + '\n');
+    result.append(histogramLine(QStringLiteral("DNS"), m_dns));
+    result.append(histogramLine(QStringLiteral("TCP connect"), m_connect));
+    result.append(histogramLine(QStringLiteral("TLS handshake"), m_handshake));
+    result.append(histogramLine(QStringLiteral("Total"), m_total));
+    return result;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QMap>
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+// Timings of one fetch, in milliseconds, -1 when a phase was not seen.
+struct HostMetrics {
+    enum Outcome {
+        Ok,
+        Timeout,
+        TlsError,
+        NetworkError
+    };
+
+    QString domain;
+    Outcome outcome = Ok;
+    QString errorName; // QNetworkReply::NetworkError or QAbstractSocket::SocketError key
+    qint64 dnsMs = -1;
+    qint64 connectMs = -1;
+    qint64 handshakeMs = -1; // HTTP mode: until the TLS session is up, includes DNS and connect
+    qint64 totalMs = -1;
+
+    QString outcomeString() const {
+        switch(outcome) {
+        case Ok: return QStringLiteral("ok");
+        case Timeout: return QStringLiteral("timeout");
+        case TlsError: return QStringLiteral("tls-error");
+        case NetworkError: break;
+        }
+        return errorName.isEmpty() ? QStringLiteral("network-error") : errorName;
+    }
+};
+Q_DECLARE_METATYPE(HostMetrics);
+
+/* Log-linear latency histogram, exact below 16 ms and within 12.5%
+ * above that. Constant memory no matter how many hosts are scanned.
+ */
+class LatencyHistogram
+{
+public:
+    void add(qint64 ms);
+    qint64 percentile(double p) const;
+    int count() const;
+    void clear();
+
+private:
+    static int bucketFor(qint64 ms);
+    static qint64 upperBound(int bucket);
+    QVector<int> m_buckets;
+    int m_count = 0;
+};
+
+// Per phase histograms and outcome counts of a scan. Thread safe.
+class ScanMetrics
+{
+public:
+    void record(const HostMetrics& metrics);
+    // lookups done by a separate resolver stage
+    void recordDns(qint64 ms);
+    void clear();
+
+    // {hosts, outcomes: {name: count}, dns|connect|handshake|total: {count, p50, p95, p99}}
+    QVariantMap summary() const;
+    QString summaryText() const;
+
+private:
+    mutable QMutex m_mutex;
+    LatencyHistogram m_dns;
+    LatencyHistogram m_connect;
+    LatencyHistogram m_handshake;
+    LatencyHistogram m_total;
+    QMap<QString, int> m_outcomes;
+    int m_hosts = 0;
+};
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scanresultwriter.h"
+
+#include <cstdio>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+namespace {
+const int flushThreshold = 64 * 1024;
+const int flushIntervalMs = 1000;
+}
+
+ScanResultWriter::ScanResultWriter(Format format, bool includePem)
+    : m_format(format), m_includePem(includePem)
+{
+
+}
+
+ScanResultWriter::~ScanResultWriter()
+{
+    close();
+}
+
+ScanResultWriter::Format ScanResultWriter::formatForPath(const QString &path)
+{
+    if(QFileInfo(path).suffix().compare("csv", Qt::CaseInsensitive) == 0)
+        return Csv;
+    return JsonLines;
+}
+
+bool ScanResultWriter::open(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    bool opened = false;
+    if(path == "-") {
+        opened = m_file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        m_file.setFileName(path);
+        opened = m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if(!opened)
+        return false;
+
+    m_pemWritten.clear();
+    m_buffer.reserve(flushThreshold * 2);
+    m_buffer.resize(0);
+    m_lastFlush.start();
+
+    if(m_format == Csv)
+        m_buffer.append("domains,count,kind,sha256,subject,issuer,valid_from,valid_until,is_ca,self_signed,trusted_root,subject_alt_names,errors,pem\n");
+    return true;
+}
+
+void ScanResultWriter::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_file.isOpen())
+        return;
+    flushIfNeeded(true);
+    m_file.close();
+}
+
+QString ScanResultWriter::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.errorString();
+}
+
+void ScanResultWriter::writeHost(const QString &hostname, const QList<Certificate> &certificates)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_file.isOpen())
+        return;
+
+    for(const Certificate& c : certificates) {
+        bool withPem = false;
+        if(m_includePem && !c._actualCert.isNull() && !m_pemWritten.contains(c.digest)) {
+            m_pemWritten.insert(c.digest);
+            withPem = true;
+        }
+        appendRecord(c, hostname, 1, withPem);
+    }
+    flushIfNeeded(false);
+}
+
+void ScanResultWriter::writeCertificate(const Certificate &certificate)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_file.isOpen())
+        return;
+
+    appendRecord(certificate, certificate.domains.join(" "), certificate.count, m_includePem && !certificate._actualCert.isNull());
+    flushIfNeeded(false);
+}
+
+void ScanResultWriter::writeMetrics(const QVariantMap &summary)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_file.isOpen() || m_format != JsonLines)
+        return;
+
+    QJsonObject record = QJsonObject::fromVariantMap(summary);
+    record.insert("type", "metrics");
+    m_buffer.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    m_buffer.append('\n');
+    flushIfNeeded(false);
+}
+
+void ScanResultWriter::appendRecord(const Certificate &c, const QString &domains, int count, bool withPem)
+{
+    const QString pem = withPem ? QString::fromLatin1(c._actualCert.toPem()) : QString();
+
+    if(m_format == JsonLines) {
+        QJsonObject record {
+            {"domains", domains},
+            {"count", count},
+            {"kind", c.kindString()},
+            {"sha256", QString::fromLatin1(c.digest.toHex())},
+            {"subject", c.subject.trimmed()},
+            {"issuer", c.issuer.trimmed()},
+            {"validFrom", c.validFromDate.toString(Qt::ISODate)},
+            {"validUntil", c.validUntilDate.toString(Qt::ISODate)},
+            {"isCA", c.isCA},
+            {"selfSigned", c.isSelfSigned},
+            {"trustedRoot", c.isSystemTrustedRootCA},
+            {"subjectAltNames", QJsonArray::fromStringList(c.subjectAlternativeNames)},
+            {"errors", QJsonArray::fromStringList(c.errors)},
+        };
+        if(withPem)
+            record.insert("pem", pem);
+        m_buffer.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+        m_buffer.append('\n');
+        return;
+    }
+
+    m_buffer.append(csvField(domains)).append(',')
+            .append(QByteArray::number(count)).append(',')
+            .append(c.kindString().toUtf8()).append(',')
+            .append(c.digest.toHex()).append(',')
+            .append(csvField(c.subject.trimmed())).append(',')
+            .append(csvField(c.issuer.trimmed())).append(',')
+            .append(c.validFromDate.toString(Qt::ISODate).toUtf8()).append(',')
+            .append(c.validUntilDate.toString(Qt::ISODate).toUtf8()).append(',')
+            .append(c.isCA ? "true" : "false").append(',')
+            .append(c.isSelfSigned ? "true" : "false").append(',')
+            .append(c.isSystemTrustedRootCA ? "true" : "false").append(',')
+            .append(csvField(c.subjectAlternativeNames.join(" "))).append(',')
+            .append(csvField(c.errors.join(" "))).append(',')
+            .append(csvField(pem)).append('\n');
+}
+
+void ScanResultWriter::flushIfNeeded(bool force)
+{
+    if(!force && m_buffer.size() < flushThreshold && m_lastFlush.elapsed() < flushIntervalMs)
+        return;
+
+    m_file.write(m_buffer);
+    m_file.flush();
+    m_buffer.resize(0); // keeps the reserved capacity
+    m_lastFlush.restart();
+}
+
+QByteArray ScanResultWriter::csvField(const QString &value)
+{
+    QByteArray field = value.toUtf8();
+    if(!field.contains(',') && !field.contains('"') && !field.contains('\n') && !field.contains('\r'))
+        return field;
+
+    field.replace("\"", "\"\"");
+    return '"' + field + '"';
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "certificate.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVariantMap>
+
+/* Structured export of scan results, JSON Lines or CSV. Records are
+ * appended to an in-memory buffer that is written out in large chunks
+ * (or at least once a second), so it can be fed from the scan threads
+ * while the scan runs. Thread safe.
+ */
+class ScanResultWriter
+{
+public:
+    enum Format {
+        JsonLines,
+        Csv
+    };
+
+    explicit ScanResultWriter(Format format, bool includePem = false);
+    ~ScanResultWriter();
+
+    // jsonl or csv by file suffix, JSON Lines if unknown
+    static Format formatForPath(const QString& path);
+
+    // "-" writes to stdout
+    bool open(const QString& path);
+    void close();
+    QString errorString() const;
+
+    // One record per certificate of this host. A PEM body is only
+    // written the first time a certificate is seen.
+    void writeHost(const QString& hostname, const QList<Certificate>& certificates);
+    // One record for an aggregated certificate, domains and count as is.
+    void writeCertificate(const Certificate& certificate);
+    // A closing {"type": "metrics", ...} record with ScanMetrics::summary().
+    // JSON Lines only, CSV rows have no place for it.
+    void writeMetrics(const QVariantMap& summary);
+
+private:
+    void appendRecord(const Certificate& certificate, const QString& domains, int count, bool withPem);
+    void flushIfNeeded(bool force);
+    static QByteArray csvField(const QString& value);
+
+    Format m_format;
+    bool m_includePem;
+    QFile m_file;
+    QByteArray m_buffer;
+    QElapsedTimer m_lastFlush;
+    QSet<QByteArray> m_pemWritten;
+    mutable QMutex m_mutex;
+};
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scanscheduler.h"
+
+#include <algorithm>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QUrl>
+
+ScanScheduler::ScanScheduler(int concurrency, int perGroupLimit)
+{
+    setConcurrency(concurrency);
+    setPerGroupLimit(perGroupLimit);
+}
+
+QString ScanScheduler::registrableDomain(const QString &host)
+{
+    // host may carry a port, e.g. example.org:8443
+    const QString name = QUrl("https://" + host).host();
+    if(name.isEmpty())
+        return host.toLower();
+    if(!QHostAddress(name).isNull())
+        return name;
+
+    const QStringList labels = name.split('.', Qt::SkipEmptyParts);
+    if(labels.size() <= 2)
+        return name;
+
+    // second level registrations like example.co.uk or example.com.au
+    static const QStringList secondLevel = {"co", "com", "net", "org", "gov", "edu", "ac", "or", "ne", "go"};
+    int keep = 2;
+    if(labels.last().size() == 2 && secondLevel.contains(labels.at(labels.size() - 2)))
+        keep = 3;
+    return labels.mid(labels.size() - std::min(keep, int(labels.size()))).join('.');
+}
+
+bool ScanScheduler::isReady(const Group &group) const
+{
+    return !group.queue.isEmpty() && group.inFlight < m_perGroupLimit;
+}
+
+void ScanScheduler::rebuildReady()
+{
+    m_ready.clear();
+    for(auto it = m_groups.constBegin(); it != m_groups.constEnd(); ++it) {
+        if(isReady(it.value()))
+            m_ready.enqueue(it.key());
+    }
+}
+
+void ScanScheduler::enqueue(const QStringList &hosts)
+{
+    for(const QString& host : hosts)
+        enqueue(host, registrableDomain(host));
+}
+
+void ScanScheduler::enqueue(const QString &host, const QString &group)
+{
+    QMutexLocker locker(&m_mutex);
+    Group& g = m_groups[group];
+    const bool wasReady = isReady(g);
+    g.queue.enqueue(host);
+    if(!wasReady && isReady(g))
+        m_ready.enqueue(group);
+    m_hostGroup.insert(host, group);
+    ++m_queued;
+    m_slotFreed.wakeAll();
+}
+
+void ScanScheduler::openInput()
+{
+    QMutexLocker locker(&m_mutex);
+    m_inputOpen = true;
+}
+
+void ScanScheduler::closeInput()
+{
+    QMutexLocker locker(&m_mutex);
+    m_inputOpen = false;
+    m_slotFreed.wakeAll();
+}
+
+bool ScanScheduler::takeNext(QString &out_host, QString *out_group)
+{
+    QMutexLocker locker(&m_mutex);
+    // hosts can be queued while no group is below its cap, wait for a finish then
+    while(!m_stopped && ((m_queued == 0 && m_inputOpen)
+                          || (m_queued > 0 && (m_inFlight >= m_concurrency || m_ready.isEmpty()))))
+        m_slotFreed.wait(&m_mutex);
+
+    if(m_stopped || m_queued == 0)
+        return false;
+
+    const QString group = m_ready.dequeue();
+    Group& g = m_groups[group];
+    out_host = g.queue.dequeue();
+    if(out_group)
+        *out_group = group;
+    ++g.inFlight;
+    --m_queued;
+    ++m_inFlight;
+    if(isReady(g))
+        m_ready.enqueue(group); // back of the line, the other groups go first
+    return true;
+}
+
+void ScanScheduler::finish(const QString &host)
+{
+    QMutexLocker locker(&m_mutex);
+    --m_inFlight;
+
+    const QString group = m_hostGroup.value(host);
+    auto it = m_groups.find(group);
+    if(it != m_groups.end()) {
+        const bool wasReady = isReady(it.value());
+        --it->inFlight;
+        if(!wasReady && isReady(it.value()))
+            m_ready.enqueue(group);
+        else if(it->queue.isEmpty() && it->inFlight <= 0)
+            m_groups.erase(it);
+    }
+    m_slotFreed.wakeAll();
+}
+
+void ScanScheduler::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_slotFreed.wakeAll();
+}
+
+void ScanScheduler::waitForIdle()
+{
+    QMutexLocker locker(&m_mutex);
+    while(m_inFlight > 0)
+        m_slotFreed.wait(&m_mutex);
+}
+
+int ScanScheduler::concurrency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_concurrency;
+}
+
+void ScanScheduler::setConcurrency(int newConcurrency)
+{
+    QMutexLocker locker(&m_mutex);
+    m_concurrency = std::max(1, newConcurrency);
+    m_slotFreed.wakeAll();
+}
+
+int ScanScheduler::perGroupLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_perGroupLimit;
+}
+
+void ScanScheduler::setPerGroupLimit(int newPerGroupLimit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_perGroupLimit = std::max(1, newPerGroupLimit);
+    rebuildReady();
+    m_slotFreed.wakeAll();
+}
+
+int ScanScheduler::inFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlight;
+}
+
+int ScanScheduler::queued() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queued;
+}
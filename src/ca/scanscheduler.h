@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+/* Sliding window work queue for the host scan. A new host is handed out
+ * as soon as one of the in-flight hosts finishes, instead of waiting for
+ * a whole batch to complete. Thread safe, takeNext() blocks the caller
+ * until a slot is free.
+ *
+ * Hosts are queued per group (registrable domain or IP address), groups
+ * take turns and each has its own cap on hosts in flight, so hundreds of
+ * subdomains of one provider can not take all slots and trip its rate
+ * limiting. Other groups keep the global window full meanwhile.
+ */
+class ScanScheduler
+{
+public:
+    explicit ScanScheduler(int concurrency = 10, int perGroupLimit = 4);
+
+    // example.org for www.example.org:8443, example.co.uk for a.b.example.co.uk,
+    // IP addresses as is. A heuristic, there is no public suffix list.
+    static QString registrableDomain(const QString& host);
+
+    // grouped by registrableDomain()
+    void enqueue(const QStringList& hosts);
+    void enqueue(const QString& host, const QString& group);
+
+    // While the input is open takeNext() waits for more hosts instead of
+    // returning false on an empty queue. Closed by default.
+    void openInput();
+    void closeInput();
+
+    // Blocks until a slot is free and a host is queued. Returns false when
+    // the queue is drained (and the input closed) or the scheduler is stopped.
+    bool takeNext(QString& out_host, QString* out_group = nullptr);
+    void finish(const QString& host);
+
+    void stop();
+    void waitForIdle();
+
+    int concurrency() const;
+    void setConcurrency(int newConcurrency);
+
+    int perGroupLimit() const;
+    void setPerGroupLimit(int newPerGroupLimit);
+
+    int inFlight() const;
+    int queued() const;
+
+private:
+    struct Group {
+        QQueue<QString> queue;
+        int inFlight = 0;
+    };
+
+    bool isReady(const Group& group) const;
+    void rebuildReady();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_slotFreed;
+    QHash<QString, Group> m_groups;
+    QQueue<QString> m_ready; // groups with queued hosts below their cap, round robin
+    QHash<QString, QString> m_hostGroup;
+    int m_concurrency = 10;
+    int m_perGroupLimit = 4;
+    int m_inFlight = 0;
+    int m_queued = 0;
+    bool m_inputOpen = false;
+    bool m_stopped = false;
+};
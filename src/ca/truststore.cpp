@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "truststore.h"
+
+#include <QCryptographicHash>
+#include <QSslConfiguration>
+
+TrustStore::TrustStore(const QList<QSslCertificate> &certificates)
+    : m_certificates(certificates)
+{
+    m_byDigest.reserve(m_certificates.size());
+    m_bySubject.reserve(m_certificates.size());
+    for(int i = 0; i < m_certificates.size(); ++i) {
+        const QSslCertificate& cert = m_certificates.at(i);
+        m_byDigest.insert(digestOf(cert), i);
+        // first one wins when several roots share a name, same as a linear search would
+        const QString subject = cert.subjectDisplayName();
+        if(!m_bySubject.contains(subject))
+            m_bySubject.insert(subject, i);
+    }
+}
+
+const TrustStore &TrustStore::system()
+{
+    static const TrustStore systemStore(QSslConfiguration::systemCaCertificates());
+    return systemStore;
+}
+
+QByteArray TrustStore::digestOf(const QSslCertificate &cert)
+{
+    return cert.digest(QCryptographicHash::Sha256);
+}
+
+const QList<QSslCertificate> &TrustStore::certificates() const
+{
+    return m_certificates;
+}
+
+bool TrustStore::contains(const QSslCertificate &cert) const
+{
+    return containsDigest(digestOf(cert));
+}
+
+bool TrustStore::containsDigest(const QByteArray &digest) const
+{
+    return m_byDigest.contains(digest);
+}
+
+QSslCertificate TrustStore::findIssuer(const QSslCertificate &cert) const
+{
+    auto it = m_bySubject.constFind(cert.issuerDisplayName());
+    if(it == m_bySubject.constEnd())
+        return QSslCertificate();
+    return m_certificates.at(it.value());
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSslCertificate>
+#include <QString>
+
+/* Immutable index over a set of trusted root certificates. The system
+ * store is loaded and parsed once, after that lookups by digest and by
+ * subject name are hash lookups instead of linear scans. Safe to share
+ * between threads since it is never modified after construction.
+ */
+class TrustStore
+{
+public:
+    explicit TrustStore(const QList<QSslCertificate>& certificates);
+
+    static const TrustStore& system();
+    static QByteArray digestOf(const QSslCertificate& cert);
+
+    const QList<QSslCertificate>& certificates() const;
+    bool contains(const QSslCertificate& cert) const;
+    bool containsDigest(const QByteArray& digest) const;
+    // root certificate whose subject matches the issuer of cert, null if none
+    QSslCertificate findIssuer(const QSslCertificate& cert) const;
+
+private:
+    QList<QSslCertificate> m_certificates;
+    QHash<QByteArray, int> m_byDigest;
+    QHash<QString, int> m_bySubject;
+};
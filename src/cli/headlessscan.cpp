@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headlessscan.h"
+#include "src/domainsources/browserhistorydb.h"
+#include "src/domainsources/domainslisttextfile.h"
+
+#include <cstring>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QUrl>
+
+HeadlessScan::HeadlessScan(QObject *parent)
+    : QObject{parent}, m_out(stdout), m_err(stderr)
+{
+    m_gatherer = new CAConcurrentGatherer(this);
+    connect(m_gatherer, &CAConcurrentGatherer::hostFinished, this, &HeadlessScan::onHostFinished, Qt::QueuedConnection);
+    connect(m_gatherer, &CAConcurrentGatherer::busyChanged, this, &HeadlessScan::onBusyChanged, Qt::QueuedConnection);
+}
+
+bool HeadlessScan::isRequested(int argc, char *argv[])
+{
+    // decided before any QCoreApplication exists, so no QCommandLineParser yet
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+    return false;
+}
+
+bool HeadlessScan::start(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Which root certificates should you trust? Headless scan, one line per certificate on stdout.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+        {"headless", "Run without GUI."},
+        {"hosts", "Text file with one domain per line.", "file"},
+        {"firefox", "Firefox places.sqlite history file.", "file"},
+        {"chrome", "Chrome/Edge History file.", "file"},
+        {"profile", "Firefox or Chrome/Edge history file or profile directory, the browser is detected. Can be given more than once, the domain counts are added up.", "path"},
+        {"all-profiles", "Read the history of every Firefox, Chrome, Chromium and Edge profile of the current user."},
+        {"incremental", "With --firefox, --chrome or --profile, only read history visits newer than the last --incremental run and add them to the counts stored then."},
+        {"incremental-reset", "Like --incremental, but forget the stored counts first and read the whole history again."},
+        {"history-mode", "How the history file is opened: snapshot (a copy), immutable (read only without locks, misses the newest visits) or live.", "mode", "snapshot"},
+        {"concurrency", "Number of domains checked at once to start with.", "n", QString::number(m_gatherer->concurrency())},
+        {"per-group", "Maximum number of domains on one IP address checked at once.", "n", QString::number(m_gatherer->perGroupConcurrency())},
+        {"fixed-concurrency", "Keep --concurrency for the whole scan instead of adapting it to the network."},
+        {"handshake-only", "Only do the TLS handshake, no HTTP request."},
+        {"format", "Output format: text, jsonl or csv. jsonl ends with a metrics record, csv has no metrics (they are on stderr).", "format", "text"},
+        {"pem", "Include the PEM of every certificate in jsonl/csv output."},
+        {"resume", "Continue the last interrupted scan instead of starting a new one."},
+        {"cache-ttl", "Reuse results of hosts fetched less than this many hours ago, 0 disables the cache.", "hours", QString::number(m_gatherer->cacheTtlHours())},
+    });
+    parser.process(arguments);
+
+    const QString format = parser.value("format");
+    if(format == "jsonl" || format == "csv") {
+        m_writer.reset(new ScanResultWriter(format == "csv" ? ScanResultWriter::Csv : ScanResultWriter::JsonLines, parser.isSet("pem")));
+        m_writer->open("-");
+    } else if(format != "text") {
+        m_err << "Unknown format " << format << ", use text, jsonl or csv" << Qt::endl;
+        return false;
+    }
+
+    const bool resume = parser.isSet("resume");
+    if(!resume && !loadHostnames(parser))
+        return false;
+
+    m_gatherer->setConcurrency(parser.value("concurrency").toInt());
+    m_gatherer->setPerGroupConcurrency(parser.value("per-group").toInt());
+    m_gatherer->setAdaptiveConcurrency(!parser.isSet("fixed-concurrency"));
+    m_gatherer->setHandshakeOnly(parser.isSet("handshake-only"));
+    m_gatherer->setCacheTtlHours(parser.value("cache-ttl").toInt());
+    if(resume) {
+        m_gatherer->resumeFromCheckpoint();
+        m_hostnames = m_gatherer->hostnames();
+    } else {
+        m_gatherer->setHostnames(m_hostnames);
+        m_gatherer->startGatherCertificatesInBackground();
+    }
+
+    if(!m_gatherer->busy()) {
+        m_err << m_gatherer->statusText() << Qt::endl;
+        return false;
+    }
+
+    m_err << "Checking " << m_hostnames.size() << " domains, " << m_gatherer->concurrency() << " at once" << Qt::endl;
+    return true;
+}
+
+bool HeadlessScan::loadHostnames(const QCommandLineParser &parser)
+{
+    const QString hostsFile = parser.value("hosts");
+    const QString firefoxDb = parser.value("firefox");
+    const QString chromeDb = parser.value("chrome");
+    QStringList profiles = parser.values("profile");
+    if(parser.isSet("all-profiles"))
+        profiles += BrowserHistoryDb::defaultProfilePaths();
+
+    if(!hostsFile.isEmpty()) {
+        DomainsListTextFile txt;
+        txt.getHostnamesFromTextFile(QUrl::fromLocalFile(hostsFile));
+        if(!txt.lastError().isEmpty()) {
+            m_err << hostsFile << ": " << txt.lastError() << Qt::endl;
+            return false;
+        }
+        m_hostnames = txt.hostnames();
+    } else if(!firefoxDb.isEmpty() || !chromeDb.isEmpty() || !profiles.isEmpty()) {
+        BrowserHistoryDb db;
+        const QString historyMode = parser.value("history-mode");
+        if(historyMode == "live") {
+            db.setOpenMode(BrowserHistoryDb::Live);
+        } else if(historyMode == "immutable") {
+            db.setOpenMode(BrowserHistoryDb::Immutable);
+        } else if(historyMode != "snapshot") {
+            m_err << "Unknown history mode " << historyMode << ", use snapshot, immutable or live" << Qt::endl;
+            return false;
+        }
+
+        db.setIncremental(parser.isSet("incremental") || parser.isSet("incremental-reset"));
+        if(!profiles.isEmpty()) {
+            if(parser.isSet("incremental-reset")) {
+                for(const QString& profile : qAsConst(profiles))
+                    BrowserHistoryDb::removeHistoryIndex(profile);
+            }
+            // a profile that can't be read is reported, the others are still used
+            db.getHostnamesFromProfiles(profiles);
+            db.waitForHostnames();
+            if(!db.lastDbError().isEmpty())
+                m_err << db.lastDbError() << Qt::endl;
+        } else {
+            const QString path = firefoxDb.isEmpty() ? chromeDb : firefoxDb;
+            if(!db.openDb(QUrl::fromLocalFile(path))) {
+                m_err << path << ": " << db.lastDbError() << Qt::endl;
+                return false;
+            }
+            db.setIsFirefox(!firefoxDb.isEmpty());
+            if(parser.isSet("incremental-reset"))
+                db.resetIncremental();
+            db.getHostnamesFromDb();
+            db.waitForHostnames();
+            if(!db.lastDbError().isEmpty()) {
+                m_err << path << ": " << db.lastDbError() << Qt::endl;
+                return false;
+            }
+        }
+        m_hostnames = db.hostnames();
+    } else {
+        m_err << "Pass one of --hosts, --firefox, --chrome, --profile or --all-profiles, see --help" << Qt::endl;
+        return false;
+    }
+
+    if(m_hostnames.isEmpty()) {
+        m_err << "No domains found" << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+void HeadlessScan::onHostFinished(const QString &hostname, const QList<Certificate> &certificates)
+{
+    if(m_writer) {
+        m_writer->writeHost(hostname, certificates);
+        return;
+    }
+
+    // host <tab> kind <tab> sha256 <tab> subject <tab> issuer
+    for(const Certificate& c : certificates) {
+        m_out << hostname << '\t' << c.kindString() << '\t' << c.digest.toHex() << '\t'
+              << c.subject.trimmed() << '\t' << c.issuer.trimmed() << '\n';
+    }
+    m_out.flush();
+}
+
+void HeadlessScan::onBusyChanged()
+{
+    if(m_gatherer->busy())
+        return;
+
+    if(m_writer) {
+        m_writer->writeMetrics(m_gatherer->metrics());
+        m_writer->close();
+    }
+    m_err << m_gatherer->statusText() << Qt::endl;
+    if(m_gatherer->adaptiveConcurrency())
+        m_err << "Concurrency at the end: " << m_gatherer->currentConcurrency() << Qt::endl;
+    m_err << m_gatherer->metricsText();
+    m_err.flush();
+    QCoreApplication::exit(0);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "src/ca/caconcurrentgatherer.h"
+#include "src/ca/scanresultwriter.h"
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QTextStream>
+
+class QCommandLineParser;
+
+/* Command line scan, no QML engine or GUI platform plugin. Loads the
+ * hostnames from a text file or browser history database, drives a
+ * CAConcurrentGatherer and writes every certificate to stdout as soon
+ * as its host finishes.
+ */
+class HeadlessScan : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HeadlessScan(QObject *parent = nullptr);
+
+    static bool isRequested(int argc, char *argv[]);
+
+    // Returns false (after printing why) when the scan could not start.
+    bool start(const QStringList& arguments);
+
+private slots:
+    void onHostFinished(const QString& hostname, const QList<Certificate>& certificates);
+    void onBusyChanged();
+
+private:
+    bool loadHostnames(const QCommandLineParser& parser);
+    CAConcurrentGatherer* m_gatherer = nullptr;
+    QStringList m_hostnames;
+    QScopedPointer<ScanResultWriter> m_writer;
+    QTextStream m_out;
+    QTextStream m_err;
+};
@@ -16,72 +16,609 @@
 
 
 #include "browserhistorydb.h"
+#include "historyindex.h"
 
+#include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QHash>
 #include <QStandardPaths>
+#include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QSqlError>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrent>
 
 BrowserHistoryDb::BrowserHistoryDb(QObject *parent)
     : QObject{parent}
 {
     m_domains = new domainCountListModel(this);
+    qRegisterMetaType<QList<QIntPair>>("QList<QIntPair>");
+    connect(this, &BrowserHistoryDb::privateBatchReady, this, &BrowserHistoryDb::onBatchReady, Qt::QueuedConnection);
+    connect(this, &BrowserHistoryDb::privateReadFinished, this, &BrowserHistoryDb::onReadFinished, Qt::QueuedConnection);
+}
+
+BrowserHistoryDb::~BrowserHistoryDb()
+{
+    m_cancel = true;
+    m_reader.waitForFinished();
 }
 
 bool BrowserHistoryDb::openDb(const QUrl path)
 {
+    if(loading())
+        return false;
 
-    _db = QSqlDatabase::addDatabase("QSQLITE");
     setDbFileName(path.toLocalFile());
-    _db.setDatabaseName(dbFileName());
+    setProfilePaths({});
+
+    // only check that the file opens, the reader thread uses its own
+    // connection. Immutable takes no locks and copies nothing.
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName());
+        QString error;
+        ok = openHistoryFile(db, dbFileName(), Immutable, QString(), error);
+        if(!ok)
+            setLastDbError(error);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName());
+    return ok;
+}
+
+void BrowserHistoryDb::startReading()
+{
+    m_domains->clear();
+    setHostnames({});
+    setLastDbError({});
+    setLoading(true);
+    m_cancel = false;
+}
+
+void BrowserHistoryDb::getHostnamesFromDb()
+{
+    if(loading() || dbFileName().isEmpty())
+        return;
 
-    if(!_db.open()) {
-        setLastDbError(_db.lastError().text());
+    const QString fileName = dbFileName();
+    startReading();
+    setProfilePaths({});
+    const bool firefox = isFirefox();
+    const OpenMode mode = openMode();
+    const bool isIncremental = incremental();
+    m_reader = QtConcurrent::run([this, fileName, firefox, mode, isIncremental]() {
+        readHostnames(fileName, firefox, mode, isIncremental);
+    });
+}
+
+bool BrowserHistoryDb::resetIncremental()
+{
+    if(loading() || (dbFileName().isEmpty() && profilePaths().isEmpty()))
         return false;
-    } else {
+
+    if(profilePaths().isEmpty()) {
+        HistoryIndex::remove(dbFileName(), isFirefox());
         return true;
     }
+    for(const QString& path : profilePaths())
+        removeHistoryIndex(path);
+    return true;
+}
 
+void BrowserHistoryDb::removeHistoryIndex(const QString &path)
+{
+    // the browser is only known once the file is open, forget both
+    const QString file = historyFileIn(path);
+    if(file.isEmpty())
+        return;
+    HistoryIndex::remove(file, true);
+    HistoryIndex::remove(file, false);
 }
 
-void BrowserHistoryDb::getHostnamesFromDb()
+void BrowserHistoryDb::getHostnamesFromProfiles(const QStringList &paths)
+{
+    if(loading() || paths.isEmpty())
+        return;
+
+    startReading();
+    setProfilePaths(paths);
+    const OpenMode mode = openMode();
+    const bool isIncremental = incremental();
+    m_reader = QtConcurrent::run([this, paths, mode, isIncremental]() {
+        readProfiles(paths, mode, isIncremental);
+    });
+}
+
+void BrowserHistoryDb::getHostnamesFromAllProfiles()
 {
-    if(!_db.isOpen())
+    const QStringList paths = defaultProfilePaths();
+    if(paths.isEmpty()) {
+        setLastDbError("No Firefox, Chrome, Chromium or Edge profiles found");
         return;
+    }
+    getHostnamesFromProfiles(paths);
+}
+
+QStringList BrowserHistoryDb::defaultProfilePaths()
+{
+    // directories with one directory per profile
+    QStringList roots;
+#if defined(Q_OS_WIN)
+    const QString roaming = qEnvironmentVariable("APPDATA");
+    const QString local = qEnvironmentVariable("LOCALAPPDATA");
+    roots << roaming + "/Mozilla/Firefox/Profiles"
+          << local + "/Google/Chrome/User Data"
+          << local + "/Chromium/User Data"
+          << local + "/Microsoft/Edge/User Data";
+#elif defined(Q_OS_MACOS)
+    const QString support = QDir::homePath() + "/Library/Application Support";
+    roots << support + "/Firefox/Profiles"
+          << support + "/Google/Chrome"
+          << support + "/Chromium"
+          << support + "/Microsoft Edge";
+#else
+    const QString home = QDir::homePath();
+    roots << home + "/.mozilla/firefox"
+          << home + "/snap/firefox/common/.mozilla/firefox"
+          << home + "/.config/google-chrome"
+          << home + "/.config/chromium"
+          << home + "/.config/microsoft-edge";
+#endif
+
+    QStringList result;
+    for(const QString& root : qAsConst(roots)) {
+        const QFileInfoList profiles = QDir(root).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for(const QFileInfo& profile : profiles) {
+            const QString file = historyFileIn(profile.absoluteFilePath());
+            if(!file.isEmpty())
+                result.push_back(file);
+        }
+    }
+    return result;
+}
+
+QString BrowserHistoryDb::historyFileIn(const QString &path)
+{
+    const QFileInfo info(path);
+    if(!info.isDir())
+        return info.exists() ? info.absoluteFilePath() : QString();
+
+    for(const QString& name : {QStringLiteral("places.sqlite"), QStringLiteral("History")}) {
+        const QFileInfo file(QDir(path).filePath(name));
+        if(file.isFile())
+            return file.absoluteFilePath();
+    }
+    return QString();
+}
+
+void BrowserHistoryDb::readProfiles(const QStringList &paths, OpenMode mode, bool incremental)
+{
+    struct Profile {
+        QString path;
+        QString connectionName;
+        QList<QIntPair> counts;
+        QString error;
+    };
+
+    // the same file given twice is read once
+    QStringList files;
+    QVector<Profile> profiles;
+    for(const QString& path : paths) {
+        const QString file = historyFileIn(path);
+        if(file.isEmpty()) {
+            profiles.push_back({path, QString(), {}, "No places.sqlite or History file found"});
+            continue;
+        }
+        if(files.contains(file))
+            continue;
+        files.push_back(file);
+        profiles.push_back({file, connectionName() + "-profile-" + QString::number(files.size()), {}, QString()});
+    }
+
+    // a named connection per profile, each used only by the thread that reads it
+    QtConcurrent::blockingMap(profiles, [this, mode, incremental](Profile& profile) {
+        if(profile.connectionName.isEmpty() || m_cancel)
+            return;
+
+        QScopedPointer<QTemporaryDir> snapshotDir;
+        if(mode == Snapshot)
+            snapshotDir.reset(new QTemporaryDir);
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", profile.connectionName);
+            if(openHistoryFile(db, profile.path, mode, snapshotDir && snapshotDir->isValid() ? snapshotDir->path() : QString(), profile.error)) {
+                const QStringList tables = db.tables();
+                const bool firefox = tables.contains("moz_places") && tables.contains("moz_historyvisits");
+                const bool chrome = tables.contains("urls");
+                if(!firefox && !chrome) {
+                    profile.error = "Not a Firefox or Chrome history file";
+                } else if(incremental) {
+                    // keyed by the history file of this profile
+                    db.transaction();
+                    profile.error = countsSinceIndex(db, profile.path, firefox, profile.counts);
+                    db.commit();
+                } else {
+                    QSqlQuery query(db);
+                    query.setForwardOnly(true);
+                    if(!query.exec(firefox ? firefoxQuery() : chromeQuery()))
+                        profile.error = query.lastError().text();
+                    else
+                        profile.counts = countsFromRows(query, firefox, m_cancel);
+                    if(profile.error.isEmpty() && query.lastError().isValid())
+                        profile.error = query.lastError().text();
+                }
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(profile.connectionName);
+    });
+
+    QHash<QString, int> merged;
+    QStringList errors;
+    for(const Profile& profile : qAsConst(profiles)) {
+        if(!profile.error.isEmpty())
+            errors.push_back(profile.path + ": " + profile.error);
+        for(const QIntPair& row : profile.counts)
+            merged[row.first] += row.second;
+    }
+
+    QList<QIntPair> counts;
+    counts.reserve(merged.size());
+    for(auto it = merged.constBegin(); it != merged.constEnd(); ++it)
+        counts.push_back({it.key(), it.value()});
+    emitBatches(counts);
+    emit privateReadFinished(errors.join("; "));
+}
+
+void BrowserHistoryDb::waitForHostnames()
+{
+    m_reader.waitForFinished();
+    // deliver the queued batches and the finished signal
+    while(loading())
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+}
+
+bool BrowserHistoryDb::openHistoryFile(QSqlDatabase &db, const QString &fileName, OpenMode mode, const QString &snapshotDir, QString &out_error)
+{
+    switch(mode) {
+    case Live:
+        db.setDatabaseName(fileName);
+        break;
+    case Snapshot: {
+        if(snapshotDir.isEmpty()) {
+            out_error = "Could not create a temporary directory for " + fileName;
+            return false;
+        }
+        const QString copy = QDir(snapshotDir).filePath("history.sqlite");
+        const QString name = db.connectionName() + "-snapshot";
+        if(!vacuumInto(name, fileName, copy) && !copyChecked(name, fileName, copy)) {
+            qWarning() << "Could not take a consistent copy of" << fileName << "reading it immutable";
+            return openHistoryFile(db, fileName, Immutable, QString(), out_error);
+        }
+        db.setDatabaseName(copy);
+        break;
+    }
+    case Immutable: {
+        QUrl uri = QUrl::fromLocalFile(fileName);
+        uri.setQuery("immutable=1");
+        db.setDatabaseName(uri.toString(QUrl::FullyEncoded));
+        db.setConnectOptions("QSQLITE_OPEN_URI;QSQLITE_OPEN_READONLY");
+        break;
+    }
+    }
+
+    if(!db.open()) {
+        out_error = db.lastError().text();
+        return false;
+    }
+
+    // one sequential read of a big file, let the OS page cache do the work
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA query_only = 1;");
+    pragma.exec("PRAGMA mmap_size = 268435456;"); // 256 MiB
+    pragma.exec("PRAGMA cache_size = -65536;"); // 64 MiB
+    return true;
+}
+
+bool BrowserHistoryDb::vacuumInto(const QString &connectionName, const QString &fileName, const QString &copy)
+{
+    // one read transaction on the source, the copy includes the -wal and
+    // cannot be torn by a browser writing at the same time
+    bool ok = false;
+    {
+        QSqlDatabase source = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        source.setDatabaseName(fileName);
+        // a browser holding an exclusive lock keeps it, no use waiting
+        source.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=100");
+        if(source.open()) {
+            QSqlQuery query(source);
+            query.prepare("VACUUM INTO ?");
+            query.addBindValue(copy);
+            ok = query.exec();
+        }
+        source.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
+
+bool BrowserHistoryDb::copyChecked(const QString &connectionName, const QString &fileName, const QString &copy)
+{
+    // the browser may write between copying the file and its -wal (which
+    // holds the visits not checkpointed yet), only a copy that passes
+    // quick_check is used
+    QFile::remove(copy);
+    QFile::remove(copy + "-wal");
+    if(!QFile::copy(fileName, copy))
+        return false;
+    if(QFile::exists(fileName + "-wal") && !QFile::copy(fileName + "-wal", copy + "-wal"))
+        return false;
+
+    bool ok = false;
+    {
+        QSqlDatabase check = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        check.setDatabaseName(copy);
+        if(check.open()) {
+            QSqlQuery query(check);
+            ok = query.exec("PRAGMA quick_check;") && query.next() && query.value(0).toString() == "ok";
+        }
+        check.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
+
+void BrowserHistoryDb::readHostnames(const QString &fileName, bool firefox, OpenMode mode, bool incremental)
+{
+    const QString name = connectionName() + "-reader";
+    QString error;
+    // removed after the connection is gone
+    QScopedPointer<QTemporaryDir> snapshotDir;
+    if(mode == Snapshot)
+        snapshotDir.reset(new QTemporaryDir);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        if(openHistoryFile(db, fileName, mode, snapshotDir && snapshotDir->isValid() ? snapshotDir->path() : QString(), error)) {
+            // one read transaction, the watermark matches the rows read
+            db.transaction();
+            error = incremental ? readIncremental(db, fileName, firefox) : readAll(db, firefox);
+            db.commit();
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    emit privateReadFinished(error);
+}
 
-    QStringList hostnames;
-    QHash<QString, int> countsHash;
-    QList<QIntPair> countsList;
+QString BrowserHistoryDb::readAll(QSqlDatabase &db, bool firefox)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if(!query.exec(firefox ? firefoxQuery() : chromeQuery()))
+        return query.lastError().text();
 
-    QSqlQuery query;
-    if(isFirefox())
-        query.prepare(firefoxQuery());
-    else
-        query.prepare(chromeQuery());
+    if(firefox) {
+        // the query sorts by count, rows go out in that order
+        QList<QIntPair> batch;
+        batch.reserve(batchSize);
+        while(!m_cancel && query.next()) {
+            const QString host = hostFromRevHost(query.value(0).toString());
+            if(host.isEmpty())
+                continue;
+            batch.push_back({host, query.value(1).toInt()});
+            if(batch.size() == batchSize) {
+                emit privateBatchReady(batch);
+                batch.clear();
+                batch.reserve(batchSize);
+            }
+        }
+        if(!batch.isEmpty())
+            emit privateBatchReady(batch);
+    } else {
+        QList<QIntPair> counts = aggregateChromeRows(query, m_cancel);
+        emitBatches(counts);
+    }
+    return query.lastError().isValid() ? query.lastError().text() : QString();
+}
 
-    query.exec();
+QString BrowserHistoryDb::readIncremental(QSqlDatabase &db, const QString &fileName, bool firefox)
+{
+    QList<QIntPair> counts;
+    const QString error = countsSinceIndex(db, fileName, firefox, counts);
+    if(error.isEmpty())
+        emitBatches(counts);
+    return error;
+}
+
+QString BrowserHistoryDb::countsSinceIndex(QSqlDatabase &db, const QString &fileName, bool firefox, QList<QIntPair> &out_counts)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if(!query.exec(firefox ? "SELECT max(visit_date) FROM moz_historyvisits;" : "SELECT max(id) FROM visits;") || !query.next())
+        return query.lastError().text();
+    const qint64 newest = query.value(0).toLongLong();
+    query.finish();
 
-    while(query.next()) {
-        QString host = query.value(0).toString();
-        int count = query.value(1).toInt();
-        if(isFirefox()) {
-            host.chop(1); // remove dot
-            std::reverse(host.begin(), host.end());
+    // a history that was cleared or replaced since is read from the start
+    HistoryIndex::State index;
+    const bool known = HistoryIndex::load(fileName, firefox, index) && index.watermark <= newest;
+    if(!known)
+        index = HistoryIndex::State();
+
+    if(!known || index.watermark < newest) {
+        if(known) {
+            query.prepare(firefox ? firefoxQuerySince() : chromeQuerySince());
+            query.bindValue(":since", index.watermark);
+        } else {
+            query.prepare(firefox ? firefoxQuery() : chromeQuery());
         }
-        hostnames.push_back(host);
-        countsHash[host] = count;
+        if(!query.exec())
+            return query.lastError().text();
+
+        const QList<QIntPair> rows = countsFromRows(query, firefox, m_cancel);
+        if(query.lastError().isValid())
+            return query.lastError().text();
+        if(m_cancel)
+            return QString(); // never store a partial read
+
+        for(const QIntPair& row : qAsConst(rows))
+            index.counts[row.first] += row.second;
+        index.watermark = newest;
+        if(!HistoryIndex::save(fileName, firefox, index))
+            qWarning() << "Could not write the history index to" << HistoryIndex::pathFor(fileName, firefox);
     }
-    setLastDbError(query.lastError().text());
-    setHostnames(hostnames);
 
-    QHash<QString, int>::iterator i;
-    for(i = countsHash.begin(); i != countsHash.end(); ++i) {
-        countsList.push_back({i.key(), i.value()});
+    out_counts.reserve(index.counts.size());
+    for(auto it = index.counts.constBegin(); it != index.counts.constEnd(); ++it)
+        out_counts.push_back({it.key(), it.value()});
+    return QString();
+}
+
+QList<QIntPair> BrowserHistoryDb::countsFromRows(QSqlQuery &query, bool firefox, const std::atomic<bool> &cancel)
+{
+    if(!firefox)
+        return aggregateChromeRows(query, cancel);
+
+    QList<QIntPair> rows;
+    while(!cancel && query.next()) {
+        const QString host = hostFromRevHost(query.value(0).toString());
+        if(!host.isEmpty())
+            rows.push_back({host, query.value(1).toInt()});
     }
+    return rows;
+}
+
+QString BrowserHistoryDb::hostFromRevHost(QString revHost)
+{
+    revHost.chop(1); // remove dot
+    std::reverse(revHost.begin(), revHost.end());
+    return revHost;
+}
+
+void BrowserHistoryDb::emitBatches(QList<QIntPair> &counts)
+{
+    std::sort(counts.begin(), counts.end(), [](const QIntPair& a, const QIntPair& b) { return a.second > b.second; });
+    for(int i = 0; i < counts.size() && !m_cancel; i += batchSize)
+        emit privateBatchReady(counts.mid(i, batchSize));
+}
+
+QList<QIntPair> BrowserHistoryDb::aggregateChromeRows(QSqlQuery &query, const std::atomic<bool> &cancel)
+{
+    // one pass over the rows, hosts are only copied the first time they show up
+    QHash<QByteArray, int> counts;
+    while(!cancel && query.next()) {
+        const QByteArray url = query.value(0).toByteArray();
+        bool needsNormalizing = false;
+        QByteArray host = hostFromUrl(url, &needsNormalizing);
+        if(host.isEmpty())
+            continue;
+        if(needsNormalizing)
+            host = normalizedHost(host);
+
+        const int visits = query.value(1).toInt();
+        auto it = counts.find(host);
+        if(it != counts.end())
+            *it += visits;
+        else
+            counts.insert(QByteArray(host.constData(), host.size()), visits);
+    }
+
+    QList<QIntPair> result;
+    result.reserve(counts.size());
+    for(auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+        result.push_back({QString::fromLatin1(it.key()), it.value()});
+    return result;
+}
+
+QByteArray BrowserHistoryDb::hostFromUrl(const QByteArray &url, bool *out_needsNormalizing)
+{
+    static const char scheme[] = "https://";
+    const int schemeLength = sizeof(scheme) - 1;
+    const char* data = url.constData();
+    const int size = url.size();
+    if(size <= schemeLength || qstrnicmp(data, scheme, schemeLength) != 0)
+        return {};
+
+    // authority is everything up to the path, query or fragment
+    int hostBegin = schemeLength;
+    int portColon = -1;
+    bool inBrackets = false; // IPv6 literal
+    bool needsNormalizing = false;
+    int end = schemeLength;
+    for(; end < size; ++end) {
+        const char c = data[end];
+        if(c == '/' || c == '?' || c == '#' || c == '\\')
+            break;
+        if(c == '@') {
+            // user:password@, drop it
+            hostBegin = end + 1;
+            portColon = -1;
+            needsNormalizing = false;
+        } else if(c == '[') {
+            inBrackets = true;
+        } else if(c == ']') {
+            inBrackets = false;
+        } else if(c == ':' && !inBrackets) {
+            portColon = end;
+        } else if((c >= 'A' && c <= 'Z') || uchar(c) >= 0x80) {
+            needsNormalizing = true;
+        }
+    }
+
+    int hostEnd = end;
+    if(portColon >= 0) {
+        const int portLength = end - portColon - 1;
+        if(portLength == 0 || (portLength == 3 && qstrncmp(data + portColon + 1, "443", 3) == 0))
+            hostEnd = portColon;
+    }
+    if(hostEnd <= hostBegin)
+        return {};
+
+    if(out_needsNormalizing)
+        *out_needsNormalizing = needsNormalizing;
+    return QByteArray::fromRawData(data + hostBegin, hostEnd - hostBegin);
+}
+
+QByteArray BrowserHistoryDb::normalizedHost(const QByteArray &host)
+{
+    // the rare case, let QUrl do the IDN and case mapping
+    const QUrl url("https://" + QString::fromUtf8(host));
+    if(!url.isValid() || url.host().isEmpty())
+        return host.toLower();
+
+    QByteArray result = url.host(QUrl::EncodeUnicode).toLatin1();
+    if(url.host().contains(':'))
+        result = '[' + result + ']';
+    if(url.port() > 0 && url.port() != 443)
+        result += ':' + QByteArray::number(url.port());
+    return result;
+}
+
+void BrowserHistoryDb::onBatchReady(const QList<QIntPair> &batch)
+{
+    QStringList hosts;
+    hosts.reserve(batch.size());
+    for(const QIntPair& row : batch)
+        hosts.push_back(row.first);
+
+    m_domains->addRows(batch);
+    m_hostnames.append(hosts);
+    emit hostnamesBatchReady(hosts);
+    emit hostnamesChanged();
+}
 
-    std::sort(countsList.begin(), countsList.end(), [](const QIntPair& a, const QIntPair& b) { return a.second > b.second; });
-    m_domains->updateFromQList(countsList);
+void BrowserHistoryDb::onReadFinished(const QString &error)
+{
+    setLastDbError(error);
+    setLoading(false);
+}
+
+QString BrowserHistoryDb::connectionName() const
+{
+    return "browserhistory-" + QString::number(quintptr(this), 16);
 }
 
 QString BrowserHistoryDb::firefoxQuery()
@@ -96,13 +633,34 @@ QString BrowserHistoryDb::firefoxQuery()
 
 QString BrowserHistoryDb::chromeQuery()
 {
-    return "SELECT"
-           " SUBSTR(SUBSTR(url, INSTR(url, '//') + 2), 0, INSTR(SUBSTR(url, INSTR(url, '//') + 2), '/'))  AS domain,"
-           " SUM(visit_count) AS total_visits"
-           " FROM urls"
-           " WHERE url LIKE 'https%'"
-           " GROUP BY domain"
-           " ORDER BY total_visits DESC;";
+    // hosts are taken out of the urls in C++, see aggregateChromeRows().
+    // Visits are counted from the visits table, like chromeQuerySince()
+    // does, urls.visit_count would not add up with the incremental reads.
+    return "SELECT CAST(u.url AS BLOB), count(*)"
+           " FROM visits v"
+           " JOIN urls u ON u.id = v.url"
+           " WHERE u.url LIKE 'https%'"
+           " GROUP BY v.url;";
+}
+
+QString BrowserHistoryDb::firefoxQuerySince()
+{
+    // visits after the watermark only, visit_date is indexed
+    return "SELECT p.rev_host, count(*)"
+           " FROM moz_historyvisits v"
+           " JOIN moz_places p ON p.id = v.place_id"
+           " WHERE v.visit_date > :since AND p.url LIKE 'https%'"
+           " GROUP BY p.rev_host;";
+}
+
+QString BrowserHistoryDb::chromeQuerySince()
+{
+    // visits after the watermark only, the visit id is the rowid
+    return "SELECT CAST(u.url AS BLOB), count(*)"
+           " FROM visits v"
+           " JOIN urls u ON u.id = v.url"
+           " WHERE v.id > :since AND u.url LIKE 'https%'"
+           " GROUP BY v.url;";
 }
 
 bool BrowserHistoryDb::isFirefox() const
@@ -164,3 +722,55 @@ domainCountListModel *BrowserHistoryDb::domains() const
 {
     return m_domains;
 }
+
+BrowserHistoryDb::OpenMode BrowserHistoryDb::openMode() const
+{
+    return m_openMode;
+}
+
+void BrowserHistoryDb::setOpenMode(OpenMode newOpenMode)
+{
+    if (m_openMode == newOpenMode)
+        return;
+    m_openMode = newOpenMode;
+    emit openModeChanged();
+}
+
+bool BrowserHistoryDb::incremental() const
+{
+    return m_incremental;
+}
+
+void BrowserHistoryDb::setIncremental(bool newIncremental)
+{
+    if (m_incremental == newIncremental)
+        return;
+    m_incremental = newIncremental;
+    emit incrementalChanged();
+}
+
+QStringList BrowserHistoryDb::profilePaths() const
+{
+    return m_profilePaths;
+}
+
+void BrowserHistoryDb::setProfilePaths(const QStringList &newProfilePaths)
+{
+    if (m_profilePaths == newProfilePaths)
+        return;
+    m_profilePaths = newProfilePaths;
+    emit profilePathsChanged();
+}
+
+bool BrowserHistoryDb::loading() const
+{
+    return m_loading;
+}
+
+void BrowserHistoryDb::setLoading(bool newLoading)
+{
+    if (m_loading == newLoading)
+        return;
+    m_loading = newLoading;
+    emit loadingChanged();
+}
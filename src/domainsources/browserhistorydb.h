@@ -18,10 +18,14 @@
 
 #include "src/listmodel/domaincountlistmodel.h"
 
+#include <atomic>
+#include <QFuture>
 #include <QMap>
 #include <QUrl>
 #include <QObject>
-#include <QSqlDatabase>
+
+class QSqlDatabase;
+class QSqlQuery;
 
 typedef QPair<QString,int> QIntPair;
 
@@ -33,12 +37,63 @@ class BrowserHistoryDb : public QObject
     Q_PROPERTY(QString dbFileName READ dbFileName WRITE setDbFileName NOTIFY dbFileNameChanged FINAL)
     Q_PROPERTY(bool isFirefox READ isFirefox WRITE setIsFirefox NOTIFY isFirefoxChanged FINAL)
     Q_PROPERTY(QString lastDbError READ lastDbError WRITE setLastDbError NOTIFY lastDbErrorChanged FINAL)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(OpenMode openMode READ openMode WRITE setOpenMode NOTIFY openModeChanged FINAL)
+    Q_PROPERTY(bool incremental READ incremental WRITE setIncremental NOTIFY incrementalChanged FINAL)
+    Q_PROPERTY(QStringList profilePaths READ profilePaths NOTIFY profilePathsChanged FINAL)
 
 public:
+    // How the history file of a possibly running browser is read.
+    enum OpenMode {
+        // the file as is, waits on the browser's locks
+        Live,
+        // VACUUM INTO a temporary directory, a consistent copy that includes
+        // the latest visits. While the browser holds an exclusive lock the
+        // file and its -wal are copied and checked instead, Immutable when
+        // that copy is damaged.
+        Snapshot,
+        // read only with immutable=1, no locking at all but visits still in
+        // the -wal file are missed and a concurrent write can give odd results
+        Immutable
+    };
+    Q_ENUM(OpenMode)
+
     explicit BrowserHistoryDb(QObject *parent = nullptr);
+    ~BrowserHistoryDb();
 
     Q_INVOKABLE bool openDb(const QUrl path);
+    // Reads on a worker thread with its own connection, rows arrive in
+    // batches of batchSize via hostnamesBatchReady(), most visited first.
     Q_INVOKABLE void getHostnamesFromDb();
+    // Several history files at once, Firefox or Chrome is detected from the
+    // tables of each. Read in parallel, each on its own connection, the
+    // counts of a domain in different profiles are added up.
+    // A path may also be a profile directory. dbFileName is left alone, the
+    // paths are in profilePaths, with incremental every history file keeps
+    // its own HistoryIndex.
+    Q_INVOKABLE void getHostnamesFromProfiles(const QStringList& paths);
+    Q_INVOKABLE void getHostnamesFromAllProfiles();
+    // Forget the stored HistoryIndex of dbFileName, or of every profile
+    // after a profiles read, the next incremental read starts over with
+    // the whole history.
+    Q_INVOKABLE bool resetIncremental();
+    // path may be a profile directory
+    static void removeHistoryIndex(const QString& path);
+    // blocks until the reader is done, for callers without an event loop
+    void waitForHostnames();
+
+    // History files of the Firefox, Chrome, Chromium and Edge profiles of
+    // the current user in their default locations.
+    static QStringList defaultProfilePaths();
+
+    static constexpr int batchSize = 500;
+
+    // Host of an https URL, with the port unless it is 443, as a view into
+    // url without copying. Empty for other schemes. out_needsNormalizing is
+    // set when the host has upper case or non ASCII bytes, see normalizedHost().
+    static QByteArray hostFromUrl(const QByteArray& url, bool* out_needsNormalizing = nullptr);
+    // lower case, IDN in ACE form (punycode)
+    static QByteArray normalizedHost(const QByteArray& host);
 
     QStringList hostnames() const;
     void setHostnames(const QStringList &newHostnames);
@@ -54,7 +109,31 @@ public:
     bool isFirefox() const;
     void setIsFirefox(bool newIsFirefox);
 
+    bool loading() const;
+
+    OpenMode openMode() const;
+    void setOpenMode(OpenMode newOpenMode);
+
+    // Keep the counts and the newest visit read in a HistoryIndex, later
+    // reads of the same file only query visits after it and add those.
+    bool incremental() const;
+    void setIncremental(bool newIncremental);
+
+    // given to the last getHostnamesFromProfiles(), empty after a single file read
+    QStringList profilePaths() const;
+
+    // Opens fileName on db according to mode and sets the read pragmas,
+    // snapshotDir holds the copy in Snapshot mode and must outlive db.
+    static bool openHistoryFile(QSqlDatabase& db, const QString& fileName, OpenMode mode, const QString& snapshotDir, QString& out_error);
+
 signals:
+    void hostnamesBatchReady(const QStringList& hostnames);
+    void privateBatchReady(const QList<QIntPair>& batch);
+    void privateReadFinished(const QString& error);
+    void loadingChanged();
+    void openModeChanged();
+    void incrementalChanged();
+    void profilePathsChanged();
 
     void hostnamesChanged();
     void dbFileNameChanged();
@@ -62,13 +141,40 @@ signals:
     void domainsChanged();
     void isFirefoxChanged();
 
+private slots:
+    void onBatchReady(const QList<QIntPair>& batch);
+    void onReadFinished(const QString& error);
+
 private:
-    QSqlDatabase _db;
-    QString firefoxQuery();
-    QString chromeQuery();
+    void readHostnames(const QString& fileName, bool firefox, OpenMode mode, bool incremental);
+    QString readAll(QSqlDatabase& db, bool firefox);
+    QString readIncremental(QSqlDatabase& db, const QString& fileName, bool firefox);
+    QString countsSinceIndex(QSqlDatabase& db, const QString& fileName, bool firefox, QList<QIntPair>& out_counts);
+    void readProfiles(const QStringList& paths, OpenMode mode, bool incremental);
+    void startReading();
+    void setProfilePaths(const QStringList& newProfilePaths);
+    void emitBatches(QList<QIntPair>& counts);
+    void setLoading(bool newLoading);
+    QString connectionName() const;
+    static QString firefoxQuery();
+    static QString chromeQuery();
+    static QString firefoxQuerySince();
+    static QString chromeQuerySince();
+    static QString hostFromRevHost(QString revHost);
+    static QString historyFileIn(const QString& path);
+    static bool vacuumInto(const QString& connectionName, const QString& fileName, const QString& copy);
+    static bool copyChecked(const QString& connectionName, const QString& fileName, const QString& copy);
+    static QList<QIntPair> countsFromRows(QSqlQuery& query, bool firefox, const std::atomic<bool>& cancel);
+    static QList<QIntPair> aggregateChromeRows(QSqlQuery& query, const std::atomic<bool>& cancel);
     QStringList m_hostnames;
     QString m_dbFileName;
     QString m_lastDbError;
     domainCountListModel *m_domains = nullptr;
     bool m_isFirefox;
+    bool m_loading = false;
+    OpenMode m_openMode = Snapshot;
+    bool m_incremental = false;
+    QStringList m_profilePaths;
+    QFuture<void> m_reader;
+    std::atomic<bool> m_cancel = false;
 };
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "historyindex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const quint32 indexMagic = 0x43494849; // "CIHI"
+const quint32 indexVersion = 2; // 2: the Chrome watermark is a visits.id
+}
+
+QString HistoryIndex::pathFor(const QString &historyFile, bool firefox)
+{
+    // the same file picked through another path is the same history
+    QString canonical = QFileInfo(historyFile).canonicalFilePath();
+    if(canonical.isEmpty())
+        canonical = QFileInfo(historyFile).absoluteFilePath();
+    const QByteArray key = QCryptographicHash::hash((canonical + (firefox ? "#firefox" : "#chrome")).toUtf8(), QCryptographicHash::Sha1);
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + QStringLiteral("/history-") + QString::fromLatin1(key.toHex().left(16)) + QStringLiteral(".index");
+}
+
+bool HistoryIndex::save(const QString &historyFile, bool firefox, const State &state)
+{
+    const QString path = pathFor(historyFile, firefox);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << indexMagic << indexVersion << state.watermark << state.counts;
+
+    if(out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool HistoryIndex::load(const QString &historyFile, bool firefox, State &state)
+{
+    QFile file(pathFor(historyFile, firefox));
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != indexMagic || version != indexVersion)
+        return false;
+
+    State loaded;
+    in >> loaded.watermark >> loaded.counts;
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    state = loaded;
+    return true;
+}
+
+void HistoryIndex::remove(const QString &historyFile, bool firefox)
+{
+    QFile::remove(pathFor(historyFile, firefox));
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+/* Domain counts already read from one browser history file and the
+ * newest visit they include (the watermark), so a later run only has to
+ * read the visits after it. One file per history file in the application
+ * data folder, written atomically with QSaveFile.
+ */
+class HistoryIndex
+{
+public:
+    struct State {
+        qint64 watermark = 0; // moz_historyvisits.visit_date or visits.id
+        QHash<QString, int> counts;
+    };
+
+    static QString pathFor(const QString& historyFile, bool firefox);
+    static bool save(const QString& historyFile, bool firefox, const State& state);
+    static bool load(const QString& historyFile, bool firefox, State& state);
+    static void remove(const QString& historyFile, bool firefox);
+};
@@ -17,32 +17,90 @@
 
 #include "caissuerlistmodel.h"
 
+namespace {
+constexpr StaticRole<Certificate> certificateRoles[] = {
+    {"subject", &staticRoleSelector<Certificate, &Certificate::subject>},
+    {"subjectInfo", &staticRoleSelector<Certificate, &Certificate::subjectInfo>},
+    {"issuer", &staticRoleSelector<Certificate, &Certificate::issuer>},
+    {"issuerInfo", &staticRoleSelector<Certificate, &Certificate::issuerInfo>},
+    {"validFromDate", +[](const Certificate &i) -> QVariant { return i.validFromDate.toString(); }},
+    {"validUntilDate", +[](const Certificate &i) -> QVariant { return i.validUntilDate.toString(); }},
+    {"count", &staticRoleSelector<Certificate, &Certificate::count>},
+    {"isca", &staticRoleSelector<Certificate, &Certificate::isCA>},
+    {"istrustedrootca", &staticRoleSelector<Certificate, &Certificate::isSystemTrustedRootCA>},
+    {"domains", +[](const Certificate &i) -> QVariant { return i.domains.join(" "); }},
+    {"subjectAlternativeNames", +[](const Certificate &i) -> QVariant { return i.subjectAlternativeNames.join(" "); }},
+    {"isselfsigned", &staticRoleSelector<Certificate, &Certificate::isSelfSigned>},
+    {"errors", +[](const Certificate &i) -> QVariant { return i.errors.join(" "); }},
+};
+}
+
 CACertificateListModel::CACertificateListModel(QObject* parent) : GenericListModel<Certificate>(parent)
 {
-    addSelector("subject", [](const Certificate &i) { return i.subject; });
-    addSelector("subjectInfo", [](const Certificate &i) { return QVariant::fromValue(i.subjectInfo); });
-    addSelector("string", [](const Certificate &i) { return QString::fromStdString(i.toString()); });
-    addSelector("issuer", [](const Certificate &i) { return i.issuer; });
-    addSelector("issuerInfo", [](const Certificate &i) { return QVariant::fromValue(i.issuerInfo); });
-    addSelector("validFromDate", [](const Certificate &i) { return i.validFromDate.toString(); });
-    addSelector("validUntilDate", [](const Certificate &i) { return i.validUntilDate.toString(); });
-    addSelector("count", [](const Certificate &i) { return i.count; });
-    addSelector("isca", [](const Certificate &i) { return i.isCA; });
-    addSelector("istrustedrootca", [](const Certificate &i) { return i.isSystemTrustedRootCA; });
-    addSelector("domains", [](const Certificate &i) { return i.domains.join(" "); });
-    addSelector("subjectAlternativeNames", [](const Certificate &i) { return i.subjectAlternativeNames.join(" "); });
-    addSelector("isselfsigned", [](const Certificate &i) { return i.isSelfSigned; });
-    addSelector("errors", [](const Certificate &i) { return i.errors.join(" "); });
+    setStaticRoles(certificateRoles);
+    // needs the row for its cache, so it stays a runtime selector
+    addSelector("string", [this](const Certificate &i, const QModelIndex &index) { return cachedString(i, index.row()); });
+
+    // clear() and updateFromQList() replace all rows
+    connect(this, &QAbstractItemModel::modelReset, this, &CACertificateListModel::rebuildCaches);
+    connect(this, &QAbstractItemModel::dataChanged, this, &CACertificateListModel::invalidateStrings);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, [this]() { m_stringCache.clear(); });
 }
 
-void CACertificateListModel::addOrUpdateItem(const Certificate &item, const QString& findBySubject)
+void CACertificateListModel::addOrUpdateItem(const Certificate &item)
 {
-    auto it = std::find_if(m_listObjects.begin(), m_listObjects.end(), [&findBySubject](const Certificate& c){ return c.subject == findBySubject;});
-    if(it != m_listObjects.end())
+    auto it = m_rowByDigest.constFind(item.digest);
+    if(it != m_rowByDigest.constEnd())
     {
-        int index = std::distance(m_listObjects.begin(), it);
-        updateRow(index, item);
+        updateRow(it.value(), item);
     } else {
+        m_rowByDigest.insert(item.digest, m_listObjects.size());
         addRow(item);
     }
 }
+
+void CACertificateListModel::addOrUpdateItems(const QList<Certificate> &items)
+{
+    QList<QPair<int, Certificate>> changedRows;
+    QList<Certificate> newRows;
+    int nextRow = m_listObjects.size();
+    for(const Certificate& item : items) {
+        auto it = m_rowByDigest.constFind(item.digest);
+        if(it != m_rowByDigest.constEnd()) {
+            changedRows.push_back({it.value(), item});
+        } else {
+            m_rowByDigest.insert(item.digest, nextRow++);
+            newRows.push_back(item);
+        }
+    }
+
+    updateRows(changedRows);
+    addRows(newRows);
+}
+
+const QString &CACertificateListModel::cachedString(const Certificate &item, int row) const
+{
+    if(row >= m_stringCache.size())
+        m_stringCache.resize(m_listObjects.size());
+
+    QString& cached = m_stringCache[row];
+    if(cached.isNull())
+        cached = item.toQString();
+    return cached;
+}
+
+void CACertificateListModel::invalidateStrings(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    const int last = std::min(bottomRight.row(), static_cast<int>(m_stringCache.size()) - 1);
+    for(int row = topLeft.row(); row <= last; ++row)
+        m_stringCache[row] = QString();
+}
+
+void CACertificateListModel::rebuildCaches()
+{
+    m_stringCache.clear();
+    m_rowByDigest.clear();
+    m_rowByDigest.reserve(m_listObjects.size());
+    for(int i = 0; i < m_listObjects.size(); ++i)
+        m_rowByDigest.insert(m_listObjects.at(i).digest, i);
+}
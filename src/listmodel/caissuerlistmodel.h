@@ -19,6 +19,8 @@
 #include "src/ca/certificate.h"
 #include "genericlistmodel.h"
 #include <QPair>
+#include <QHash>
+#include <QVector>
 #include <QObject>
 
 class CACertificateListModel : public GenericListModel<Certificate>
@@ -26,6 +28,15 @@ class CACertificateListModel : public GenericListModel<Certificate>
     Q_OBJECT
 public:
     CACertificateListModel(QObject* parent = nullptr);
-    void addOrUpdateItem(const Certificate& itemToAdd, const QString& findBySubject);
+    void addOrUpdateItem(const Certificate& itemToAdd);
+    void addOrUpdateItems(const QList<Certificate>& itemsToAdd);
+
+private:
+    void rebuildCaches();
+    const QString& cachedString(const Certificate& item, int row) const;
+    void invalidateStrings(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    QHash<QByteArray, int> m_rowByDigest;
+    // rendered "string" role per row, filled on first use
+    mutable QVector<QString> m_stringCache;
 };
 
@@ -17,8 +17,14 @@
 
 #include "domaincountlistmodel.h"
 
+namespace {
+constexpr StaticRole<QIntPair> domainCountRoles[] = {
+    {"domain", &staticRoleSelector<QIntPair, &QIntPair::first>},
+    {"count", &staticRoleSelector<QIntPair, &QIntPair::second>},
+};
+}
+
 domainCountListModel::domainCountListModel(QObject* parent) : GenericListModel<QIntPair>(parent)
 {
-    addSelector("domain", [](const QIntPair &m) { return m.first; });
-    addSelector("count", [](const QIntPair &m) { return m.second; });
+    setStaticRoles(domainCountRoles);
 }
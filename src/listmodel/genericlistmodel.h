@@ -19,6 +19,23 @@
 
 #include "qabstractlistmodelwithrowcountsignal.h"
 
+#include <functional>
+
+// Entry in a compile time role table, see GenericListModel::setStaticRoles().
+template <typename TObject>
+struct StaticRole
+{
+    const char *name;
+    QVariant (*selector)(const TObject &);
+};
+
+// Selector for a member or accessor pointer, e.g. staticRoleSelector<MyObject, &MyObject::name>.
+template <typename TObject, auto Accessor>
+QVariant staticRoleSelector(const TObject &object)
+{
+    return QVariant::fromValue(std::invoke(Accessor, object));
+}
+
 template <typename TObject>
 class GenericListModel : public QAbstractListModelWithRowCountSignal
 {
@@ -34,12 +51,19 @@ public:
     void updateFromQList(const QList<TObject> &newObjects);
     void addRow(const TObject&);
     void updateRow(int rowNr, const TObject&);
+    // batch versions, one insert and as few dataChanged ranges as possible
+    void addRows(const QList<TObject>& newRows);
+    void updateRows(const QList<QPair<int, TObject>>& changedRows);
     QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
     virtual void move(int from, int to);
+    // Roles known at compile time, looked up by array index in data().
+    // Must be set before any addSelector() call, the table must outlive the model.
+    template <std::size_t N>
+    void setStaticRoles(const StaticRole<TObject> (&roles)[N]);
     int addSelector(QByteArray name, std::function<QVariant(const TObject &, const QModelIndex &)> selector);
     int addSelector(QByteArray name, std::function<QVariant(const TObject &)> selector);
     int addSelector(QByteArray name, std::function<QVariant(const TObject &)> selector, std::function<bool(TObject &, QVariant)> valueSetter);
@@ -51,6 +75,8 @@ public:
 
 protected:
     QList<TObject> m_listObjects;
+    const StaticRole<TObject> *m_staticRoles = nullptr;
+    int m_staticRoleCount = 0;
     QMap<int, QPair<QByteArray, std::function<QVariant(const TObject &, const QModelIndex &)>>> m_selectors;
     QMap<int, QPair<QByteArray, std::function<bool(TObject &, QVariant)>>> m_valueSetters;
 };
@@ -88,6 +114,8 @@ template <typename TObject>
 QHash<int, QByteArray> GenericListModel<TObject>::roleNames() const
 {
     QHash<int, QByteArray> roles;
+    for (int i = 0; i < m_staticRoleCount; ++i)
+        roles[Qt::UserRole + i + 1] = m_staticRoles[i].name;
     for (auto it = m_selectors.begin(); it != m_selectors.end(); ++it)
     {
         roles[it.key()] = it->first;
@@ -104,6 +132,10 @@ QVariant GenericListModel<TObject>::data(const QModelIndex &index, int role) con
     }
 
     const TObject &object = m_listObjects[index.row()];
+    const int staticRole = role - Qt::UserRole - 1;
+    if (staticRole >= 0 && staticRole < m_staticRoleCount)
+        return m_staticRoles[staticRole].selector(object);
+
     auto selectorIterator = m_selectors.find(role);
     if (selectorIterator != m_selectors.end())
         return selectorIterator->second(object, index);
@@ -148,7 +180,7 @@ void GenericListModel<TObject>::move(int from, int to)
 template <typename TObject>
 int GenericListModel<TObject>::addSelector(QByteArray name, std::function<QVariant(const TObject &)> selector)
 {
-    std::function<QVariant(TObject, const QModelIndex &)> newselector = std::bind(selector, std::placeholders::_1);
+    std::function<QVariant(const TObject &, const QModelIndex &)> newselector = [selector](const TObject &object, const QModelIndex &) { return selector(object); };
     return addSelector(name, newselector);
 }
 
@@ -171,11 +203,20 @@ int GenericListModel<TObject>::addSelector(QByteArray name, std::function<QVaria
 template <typename TObject>
 int GenericListModel<TObject>::addSelector(QByteArray name, std::function<QVariant(const TObject &, const QModelIndex &)> selector)
 {
-    int roleNumber = Qt::UserRole + m_selectors.size() + 1;
-    m_selectors[roleNumber] = QPair<QByteArray, std::function<QVariant(TObject, const QModelIndex &)>> {name, selector};
+    int roleNumber = Qt::UserRole + m_staticRoleCount + m_selectors.size() + 1;
+    m_selectors[roleNumber] = QPair<QByteArray, std::function<QVariant(const TObject &, const QModelIndex &)>> {name, selector};
     return roleNumber;
 }
 
+template <typename TObject>
+template <std::size_t N>
+void GenericListModel<TObject>::setStaticRoles(const StaticRole<TObject> (&roles)[N])
+{
+    Q_ASSERT(m_selectors.isEmpty());
+    m_staticRoles = roles;
+    m_staticRoleCount = static_cast<int>(N);
+}
+
 template <typename TObject>
 QVariant GenericListModel<TObject>::dataByRoleName(const QModelIndex &index, const QString &roleName) const
 {
@@ -185,6 +226,11 @@ QVariant GenericListModel<TObject>::dataByRoleName(const QModelIndex &index, con
     }
 
     const TObject &object = m_listObjects[index.row()];
+    for (int i = 0; i < m_staticRoleCount; ++i)
+    {
+        if (roleName == m_staticRoles[i].name)
+            return m_staticRoles[i].selector(object);
+    }
     for (const QPair<QByteArray, std::function<QVariant(const TObject &, const QModelIndex &)>> &mapEntry : m_selectors)
     {
         if (mapEntry.first == roleName)
@@ -222,6 +268,46 @@ void GenericListModel<TObject>::updateRow(int rowNr, const TObject& newRow)
 }
 
 
+template <typename TObject>
+void GenericListModel<TObject>::addRows(const QList<TObject>& newRows)
+{
+    if (newRows.isEmpty())
+        return;
+    auto size = m_listObjects.size();
+    emit beginInsertRows(QModelIndex(), size, size + newRows.size() - 1);
+    m_listObjects.append(newRows);
+    emit endInsertRows();
+}
+
+
+template <typename TObject>
+void GenericListModel<TObject>::updateRows(const QList<QPair<int, TObject>>& changedRows)
+{
+    QList<int> rowNrs;
+    rowNrs.reserve(changedRows.size());
+    for (const QPair<int, TObject> &changedRow : changedRows)
+    {
+        if (changedRow.first < 0 || changedRow.first >= m_listObjects.size())
+            continue;
+        m_listObjects[changedRow.first] = changedRow.second;
+        rowNrs.push_back(changedRow.first);
+    }
+
+    // coalesce into contiguous ranges
+    std::sort(rowNrs.begin(), rowNrs.end());
+    int i = 0;
+    while (i < rowNrs.size())
+    {
+        int first = rowNrs.at(i);
+        int last = first;
+        while (i + 1 < rowNrs.size() && rowNrs.at(i + 1) <= last + 1)
+            last = rowNrs.at(++i);
+        emit dataChanged(index(first), index(last));
+        ++i;
+    }
+}
+
+
 template <typename TObject>
 int GenericListModel<TObject>::getRoleIdByName(const QString &name) const
 {
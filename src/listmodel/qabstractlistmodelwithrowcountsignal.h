@@ -30,14 +30,24 @@ protected:
     QAbstractListModelWithRowCountSignal(QObject *parent = nullptr) :
         QAbstractListModel(parent)
     {
-        QObject::connect(this, &QAbstractListModel::rowsInserted, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
-        QObject::connect(this, &QAbstractListModel::rowsRemoved, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
-        QObject::connect(this, &QAbstractListModel::modelReset, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
-        QObject::connect(this, &QAbstractListModel::layoutChanged, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
-        QObject::connect(this, &QAbstractListModel::rowsMoved, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
-        QObject::connect(this, &QAbstractListModel::dataChanged, this, &QAbstractListModelWithRowCountSignal::rowCountChanged);
+        // only notify when the count actually changed, every notification
+        // re-evaluates the QML bindings on rowCount
+        const auto checkRowCount = [this]() {
+            const int newRowCount = rowCount();
+            if (newRowCount == m_lastRowCount)
+                return;
+            m_lastRowCount = newRowCount;
+            emit rowCountChanged();
+        };
+        QObject::connect(this, &QAbstractListModel::rowsInserted, this, checkRowCount);
+        QObject::connect(this, &QAbstractListModel::rowsRemoved, this, checkRowCount);
+        QObject::connect(this, &QAbstractListModel::modelReset, this, checkRowCount);
+        QObject::connect(this, &QAbstractListModel::layoutChanged, this, checkRowCount);
     }
 
 signals:
     void rowCountChanged();
+
+private:
+    int m_lastRowCount = 0;
 };
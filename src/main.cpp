@@ -19,6 +19,7 @@
 #include "src/domainsources/browserhistorydb.h"
 #include "src/domainsources/domainslisttextfile.h"
 #include "src/versioncheck/versioncheck.h"
+#include "src/cli/headlessscan.h"
 
 #include <QQuickStyle>
 #include <QQmlFileSelector>
@@ -33,6 +34,19 @@ void destroy(QObject*);
 
 int main(int argc, char *argv[])
 {
+    if(HeadlessScan::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        app.setOrganizationName("Sparkling Network");
+        app.setOrganizationDomain("raymii.org");
+        app.setApplicationName("FF Cert Cleanup");
+        app.setApplicationVersion(APP_VERSION);
+
+        HeadlessScan scan;
+        if(!scan.start(app.arguments()))
+            return 1;
+        return app.exec();
+    }
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
@@ -141,6 +141,17 @@ Window {
                 onClicked: textFileDialog.open()
             }
 
+            Button {
+                id: openProfilesButton
+                anchors.top: openTxtButton.bottom
+                anchors.left: parent.left
+                anchors.margins: 5
+                width: 300
+                text: "Read all browser profiles"
+                enabled: !proc.busy && !db.loading
+                onClicked: db.getHostnamesFromAllProfiles()
+            }
+
             Button {
                 id: startButton
                 anchors.top: parent.top
@@ -149,7 +160,12 @@ Window {
                 width: 300
                 text: proc.busy ? "STOP" : "START"
 
-                onClicked: proc.startGatherCertificatesInBackground()
+                onClicked: {
+                    // later history batches only belong to a scan of the history
+                    if(!proc.busy)
+                        proc.scanningHistory = db.loading && (db.domains.rowCount > 0 || txt.domains.rowCount === 0)
+                    proc.startGatherCertificatesInBackground()
+                }
 
                 contentItem: Text {
                     text: startButton.text
@@ -183,7 +199,7 @@ Window {
                 anchors.top: parent.top
                 anchors.margins: 5
                 font.pixelSize: 12
-                text: db.dbFileName === "" ? txt.lastError === "" ? txt.textFileName : txt.lastError : db.lastDbError === "" ? db.dbFileName : db.lastDbError
+                text: db.dbFileName === "" && db.profilePaths.length === 0 ? txt.lastError === "" ? txt.textFileName : txt.lastError : db.lastDbError === "" ? db.profilePaths.length > 0 ? db.profilePaths.join(", ") : db.dbFileName : db.lastDbError
             }
 
             Text {
@@ -219,9 +235,85 @@ Window {
                 padding: 2
             }
 
+            Text {
+                id: concurrencyText
+                anchors.left: prgbr.right
+                anchors.verticalCenter: prgbr.verticalCenter
+                anchors.margins: 5
+                font.pixelSize: 12
+                text: proc.currentConcurrency + " at once"
+                visible: proc.busy
+            }
+
+            CheckBox {
+                id: handshakeOnlyCheckBox
+                anchors.top: prgbr.bottom
+                anchors.left: search.right
+                anchors.margins: 5
+                text: "TLS handshake only (no HTTP request)"
+                enabled: !proc.busy
+                checked: proc.handshakeOnly
+                onToggled: proc.handshakeOnly = checked
+            }
+
+            Button {
+                id: resumeButton
+                anchors.top: prgbr.bottom
+                anchors.left: handshakeOnlyCheckBox.right
+                anchors.margins: 5
+                text: "Resume last scan"
+                visible: proc.hasCheckpoint && !proc.busy
+
+                onClicked: {
+                    proc.scanningHistory = false
+                    proc.resumeFromCheckpoint()
+                }
+            }
+
+            SpinBox {
+                id: cacheTtlSpinBox
+                anchors.top: prgbr.bottom
+                anchors.left: resumeButton.visible ? resumeButton.right : handshakeOnlyCheckBox.right
+                anchors.margins: 5
+                from: 0
+                to: 720
+                enabled: !proc.busy
+                value: proc.cacheTtlHours
+                onValueModified: proc.cacheTtlHours = value
+            }
+
+            Text {
+                id: cacheTtlText
+                anchors.left: cacheTtlSpinBox.right
+                anchors.verticalCenter: cacheTtlSpinBox.verticalCenter
+                anchors.margins: 5
+                text: proc.cacheTtlHours === 0 ? "Cache off" : "Hours to reuse cached results"
+            }
+
+            Button {
+                id: clearCacheButton
+                anchors.top: prgbr.bottom
+                anchors.left: cacheTtlText.right
+                anchors.margins: 5
+                text: "Clear cache"
+                enabled: !proc.busy
+
+                onClicked: proc.clearScanCache()
+            }
+
+            CheckBox {
+                id: includePemCheckBox
+                anchors.top: prgbr.bottom
+                anchors.left: clearCacheButton.right
+                anchors.margins: 5
+                text: "PEM in JSON Lines / CSV exports"
+                checked: exportFileDialog.includePem
+                onToggled: exportFileDialog.includePem = checked
+            }
+
             Text {
                 id: domainsHeader
-                anchors.top: openTxtButton.bottom
+                anchors.top: openProfilesButton.bottom
                 anchors.left: parent.left
                 height: 25
                 width: 300
@@ -523,9 +615,25 @@ This tool parses your browser history and retreives all certificates from all do
 
 in your history. No data is sent to a third-party service except for the GET request
 
-to said domain. All this is done locally on your own device.
+to said domain. All this is done locally on your own device. With *TLS handshake only*
+
+checked, not even the GET request is sent, just the TLS handshake.
+
+HTTP requests start 10 at once, the next domain starts as soon as one finishes.
+
+The number of domains checked at once adapts to your network: it goes up while that
+
+speeds up the scan and down when timeouts or connection errors pile up.
+
+Domains that no longer exist are skipped after a DNS lookup, they do not wait for a timeout.
 
-HTTP requests are sent 10 at once.
+*Read all browser profiles* reads the history of every Firefox, Chrome, Chromium and
+
+Edge profile on this account at once, a domain visited in several profiles is checked once.
+
+With a cache time set, domains checked within that many hours are taken from a local cache.
+
+An interrupted scan (app closed or stopped) can be continued with *Resume last scan*.
 
 When finished, in the *Untrusted System Root CA's* column, you'll find
 
@@ -812,6 +920,17 @@ GNU Lesser General Public License v2.1
     CAConcurrentGatherer {
         id: proc;
         hostnames: db.domains.rowCount === 0 ? txt.hostnames : db.hostnames
+        // a scan started while the history is read picks up the rest as it comes in
+        property bool scanningHistory: false
+        hostnamesComplete: !scanningHistory || !db.loading
+    }
+
+    Connections {
+        target: db
+        function onHostnamesBatchReady(batch) {
+            if(proc.busy && proc.scanningHistory)
+                proc.appendHostnames(batch)
+        }
     }
 
     C.ImportHostsFileDialog {
@@ -0,0 +1,27 @@
+# Tests for reading browser history, built on their own:
+#   qmake tests/browserhistorydb/browserhistorydb.pro && make && ./tst_browserhistorydb
+
+QT += sql concurrent testlib
+QT -= gui
+
+TARGET = tst_browserhistorydb
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS = -Wno-deprecated-declarations
+
+# sources include each other as "src/..."
+INCLUDEPATH += $$PWD/../..
+
+HEADERS += \
+    ../../src/domainsources/browserhistorydb.h \
+    ../../src/domainsources/historyindex.h \
+    ../../src/listmodel/domaincountlistmodel.h \
+    ../../src/listmodel/genericlistmodel.h \
+    ../../src/listmodel/qabstractlistmodelwithrowcountsignal.h
+
+SOURCES += \
+    tst_browserhistorydb.cpp \
+    ../../src/domainsources/browserhistorydb.cpp \
+    ../../src/domainsources/historyindex.cpp \
+    ../../src/listmodel/domaincountlistmodel.cpp
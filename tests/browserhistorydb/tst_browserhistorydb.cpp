@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023 Remy van Elst https://raymii.org
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/domainsources/browserhistorydb.h"
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class TestBrowserHistoryDb : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void incrementalMatchesFullRead();
+
+private:
+    // url -> number of visits to add, in a Chrome History schema
+    static void addChromeVisits(const QString& file, const QList<QPair<QString, int>>& visits);
+    static QHash<QString, int> read(const QString& file, bool incremental);
+};
+
+void TestBrowserHistoryDb::initTestCase()
+{
+    // the history index goes to a test location, not the real app data
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestBrowserHistoryDb::addChromeVisits(const QString &file, const QList<QPair<QString, int>> &visits)
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "tst-writer");
+        db.setDatabaseName(file);
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec("CREATE TABLE IF NOT EXISTS urls(id INTEGER PRIMARY KEY, url LONGVARCHAR, visit_count INTEGER DEFAULT 0 NOT NULL);"));
+        QVERIFY(query.exec("CREATE TABLE IF NOT EXISTS visits(id INTEGER PRIMARY KEY AUTOINCREMENT, url INTEGER NOT NULL, visit_time INTEGER NOT NULL);"));
+        for(const auto& visit : visits) {
+            query.prepare("SELECT id FROM urls WHERE url = ?");
+            query.addBindValue(visit.first);
+            QVERIFY(query.exec());
+            qint64 urlId = 0;
+            if(query.next()) {
+                urlId = query.value(0).toLongLong();
+            } else {
+                query.prepare("INSERT INTO urls(url) VALUES(?)");
+                query.addBindValue(visit.first);
+                QVERIFY(query.exec());
+                urlId = query.lastInsertId().toLongLong();
+            }
+            for(int i = 0; i < visit.second; ++i) {
+                query.prepare("INSERT INTO visits(url, visit_time) VALUES(?, ?)");
+                query.addBindValue(urlId);
+                query.addBindValue(QDateTime::currentMSecsSinceEpoch() * 1000);
+                QVERIFY(query.exec());
+            }
+            // Chrome keeps a running total here, it is not what gets counted
+            query.prepare("UPDATE urls SET visit_count = visit_count + 100 WHERE id = ?");
+            query.addBindValue(urlId);
+            QVERIFY(query.exec());
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("tst-writer");
+}
+
+QHash<QString, int> TestBrowserHistoryDb::read(const QString &file, bool incremental)
+{
+    BrowserHistoryDb db;
+    db.setOpenMode(BrowserHistoryDb::Live);
+    db.setIncremental(incremental);
+    if(!db.openDb(QUrl::fromLocalFile(file)))
+        return {};
+    db.setIsFirefox(false);
+    db.getHostnamesFromDb();
+    db.waitForHostnames();
+
+    const QHash<int, QByteArray> roles = db.domains()->roleNames();
+    const int domainRole = roles.key("domain");
+    const int countRole = roles.key("count");
+    QHash<QString, int> counts;
+    for(int row = 0; row < db.domains()->rowCount(); ++row) {
+        const QModelIndex index = db.domains()->index(row);
+        counts.insert(index.data(domainRole).toString(), index.data(countRole).toInt());
+    }
+    return counts;
+}
+
+void TestBrowserHistoryDb::incrementalMatchesFullRead()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString file = dir.filePath("History");
+
+    addChromeVisits(file, {{"https://a.example.org/", 3}, {"https://b.example.org/x", 1}, {"http://plain.example.org/", 2}});
+    const QHash<QString, int> first = read(file, true);
+    QCOMPARE(first.value("a.example.org"), 3);
+    QCOMPARE(first.value("b.example.org"), 1);
+    QVERIFY(!first.contains("plain.example.org"));
+
+    // only these visits are read by the second incremental run
+    addChromeVisits(file, {{"https://a.example.org/other", 2}, {"https://c.example.org:8443/", 4}});
+    const QHash<QString, int> incremental = read(file, true);
+    const QHash<QString, int> full = read(file, false);
+    QCOMPARE(incremental, full);
+    QCOMPARE(full.value("a.example.org"), 5);
+    QCOMPARE(full.value("c.example.org:8443"), 4);
+
+    // nothing new, the stored counts are returned as is
+    QCOMPARE(read(file, true), full);
+}
+
+QTEST_GUILESS_MAIN(TestBrowserHistoryDb)
+#include "tst_browserhistorydb.moc"